@@ -0,0 +1,212 @@
+// Host benchmark for ISO scanning, sorting, title ID extraction, title ID cache and target list snapshot.
+// iso.c is included directly to measure each stage of findISO() separately.
+#include "../src/iso.c"
+#include "iso_generator.h"
+#include <ftw.h>
+#include <stdarg.h>
+
+// Default number of titles in each benchmark run
+static const int defaultCounts[] = {100, 1000, 10000};
+// Number of ISOs in each generated directory
+#define TITLES_PER_DIRECTORY 50
+
+extern int isLogEnabled;
+static FILE *report;
+
+// Returns monotonic time in microseconds
+static int64_t getTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Prints stage time in milliseconds
+static void printTime(int64_t start) { fprintf(report, " %10.2f", (getTime() - start) / 1000.0); }
+
+static int removeEntry(const char *path, const struct stat *st, int flag, struct FTW *ftw) { return remove(path); }
+
+// Generates the ISO tree with count titles in workDir and measures all stages
+static int runBenchmark(const char *workDir, int count) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%d", workDir, count);
+  if ((mkdir(path, 0755) && (errno != EEXIST)) || chdir(path)) {
+    fprintf(stderr, "ERROR: Failed to create %s: %s\n", path, strerror(errno));
+    return -errno;
+  }
+
+  int res;
+  if ((res = generateISOTree("mass0:", count, TITLES_PER_DIRECTORY))) {
+    fprintf(stderr, "ERROR: Failed to generate ISO tree: %d\n", res);
+    return res;
+  }
+  remove("mass0:/nhddl/dirs.bin");
+  remove("mass0:/nhddl/cache.bin");
+  remove("mass0:/nhddl/targets.bin");
+  fprintf(report, "%8d", count);
+
+  // Scan the device without the directory cache
+  ScanResult scan;
+  initScanResult(&scan);
+  int64_t start = getTime();
+  if ((res = _findISO("mass0:", 0, &scan)))
+    goto fail;
+  printTime(start);
+  freeScanResult(&scan);
+
+  // Scan the device again, reusing the directory cache
+  initScanResult(&scan);
+  start = getTime();
+  if ((res = _findISO("mass0:", 0, &scan)))
+    goto fail;
+  printTime(start);
+
+  if (scan.total != count) {
+    fprintf(stderr, "\nERROR: Found %d titles instead of %d\n", scan.total, count);
+    freeScanResult(&scan);
+    return -EINVAL;
+  }
+
+  // Sort titles
+  TargetList *list = newTargetList();
+  start = getTime();
+  buildTargetList(&scan, list);
+  printTime(start);
+
+  // Extract title IDs from every ISO
+  char *titleID;
+  start = getTime();
+  for (Target *target = list->first; target != NULL; target = target->next) {
+    if ((titleID = getTitleID(target->fullPath)) == NULL) {
+      fprintf(stderr, "\nERROR: Failed to get title ID for %s\n", target->fullPath);
+      freeTargetList(list);
+      return -EIO;
+    }
+    target->id = arenaStrdup(&list->arena, titleID);
+    free(titleID);
+  }
+  printTime(start);
+
+  // Store and load title ID cache, looking up every title
+  start = getTime();
+  storeTitleIDCache(list);
+  printTime(start);
+
+  TitleIDCache *cache = malloc(sizeof(TitleIDCache));
+  start = getTime();
+  if ((res = loadTitleIDCache(cache))) {
+    fprintf(stderr, "\nERROR: Failed to load title ID cache: %d\n", res);
+    free(cache);
+    freeTargetList(list);
+    return res;
+  }
+  for (Target *target = list->first; target != NULL; target = target->next) {
+    if (getCachedTitleID(target->fullPath, target->size, cache) == NULL) {
+      fprintf(stderr, "\nERROR: %s is missing from title ID cache\n", target->fullPath);
+      res = -ENOENT;
+      break;
+    }
+  }
+  printTime(start);
+  freeTitleCache(cache);
+  if (res) {
+    fprintf(report, "\n");
+    freeTargetList(list);
+    return res;
+  }
+
+  // Store and load target list snapshot
+  start = getTime();
+  storeTargetListSnapshot(list);
+  printTime(start);
+
+  TargetList *snapshot = newTargetList();
+  start = getTime();
+  if ((res = loadTargetListSnapshot(snapshot)) == 0)
+    printTime(start);
+  fprintf(report, "\n");
+
+  if (res) {
+    fprintf(stderr, "\nERROR: Failed to load target list snapshot: %d\n", res);
+  } else if (snapshot->total != list->total) {
+    fprintf(stderr, "\nERROR: Loaded %d titles from target list snapshot instead of %d\n", snapshot->total, list->total);
+    res = -EINVAL;
+  }
+  freeTargetList(snapshot);
+  freeTargetList(list);
+  return res;
+
+fail:
+  fprintf(stderr, "\nERROR: Benchmark failed: %d\n", res);
+  freeScanResult(&scan);
+  return res;
+}
+
+int main(int argc, char *argv[]) {
+  char workDir[PATH_MAX] = "";
+  char path[PATH_MAX] = "";
+  int verbose = 0;
+  int keepWorkDir = 1;
+  int counts[16];
+  int countTotal = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) {
+      verbose = 1;
+    } else if (!strcmp(argv[i], "-w") && (i + 1 < argc)) {
+      strlcpy(path, argv[++i], sizeof(path));
+    } else if ((atoi(argv[i]) > 0) && (countTotal < sizeof(counts) / sizeof(int))) {
+      counts[countTotal++] = atoi(argv[i]);
+    } else {
+      fprintf(stderr, "Usage: %s [-v] [-w <work directory>] [title count]...\n", argv[0]);
+      fprintf(stderr, "Generated ISO trees are kept only if the work directory is specified\n");
+      return 1;
+    }
+  }
+  if (countTotal == 0) {
+    for (int i = 0; i < sizeof(defaultCounts) / sizeof(int); i++)
+      counts[countTotal++] = defaultCounts[i];
+  }
+
+  if (path[0] != '\0') {
+    if ((mkdir(path, 0755) && (errno != EEXIST)) || (realpath(path, workDir) == NULL)) {
+      fprintf(stderr, "ERROR: Failed to create work directory: %s\n", strerror(errno));
+      return 1;
+    }
+  } else {
+    // Use a temporary directory that is removed once the benchmark completes
+    strcpy(workDir, "/tmp/nhddl-bench-XXXXXX");
+    if (mkdtemp(workDir) == NULL) {
+      fprintf(stderr, "ERROR: Failed to create work directory: %s\n", strerror(errno));
+      return 1;
+    }
+    keepWorkDir = 0;
+  }
+
+  // Keep the report on stdout and silence the modules unless verbose output is requested
+  report = fdopen(dup(STDOUT_FILENO), "w");
+  setvbuf(report, NULL, _IOLBF, 0);
+  if (!verbose) {
+    isLogEnabled = 0;
+    freopen("/dev/null", "w", stdout);
+  }
+
+  // Use a single ATA device
+  deviceModeMap[0].mode = MODE_ATA;
+  for (int i = 1; i < MAX_MASS_DEVICES; i++)
+    deviceModeMap[i].mode = MODE_ALL;
+
+  fprintf(report, "Work directory: %s\nAll times are in milliseconds\n\n", workDir);
+  fprintf(report, "%8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "titles", "scan", "scan (dc)", "sort", "title IDs", "cache save", "cache load",
+          "snap save", "snap load");
+  int res = 0;
+  for (int i = 0; i < countTotal; i++) {
+    if ((res = runBenchmark(workDir, counts[i])))
+      break;
+  }
+
+  if (!keepWorkDir) {
+    chdir("/");
+    nftw(workDir, removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+  }
+  return (res) ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+// Host benchmark for BMFont text layout.
+// Lays out the text of a full title list page every frame and reports time spent per frame and per glyph
+// along with the number of GS primitives and GIF packet bytes queued for each frame.
+// gui_graphics.c is included directly to check glyph tables against the font data
+#include "../src/gui_graphics.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Default number of laid out frames
+#define DEFAULT_FRAME_COUNT 20000
+// Number of titles on the page
+#define TITLES_PER_PAGE 20
+
+// Used by gui_graphics.c
+static GSGLOBAL screen = {.Width = 640, .Height = 448};
+GSGLOBAL *gsGlobal = &screen;
+
+// Defined in shim/gskit.c
+extern int spriteCount;
+
+static const char *titleNames[] = {
+    "Ace Combat 04 - Shattered Skies",
+    "Burnout 3 - Takedown",
+    "Dark Cloud 2",
+    "Final Fantasy X",
+    "Gran Turismo 4",
+    "Grand Theft Auto - Vice City",
+    "Jak and Daxter - The Precursor Legacy",
+    "Katamari Damacy",
+    "Kingdom Hearts",
+    "Metal Gear Solid 3 - Snake Eater",
+    "Okami",
+    "Persona 4",
+    "Ratchet & Clank - Up Your Arsenal",
+    "Shadow of the Colossus",
+    "Silent Hill 2",
+    "Sly 2 - Band of Thieves",
+    "Tekken 5",
+    "Tony Hawk's Pro Skater 4",
+    "Valkyrie Profile 2 - Silmeria",
+    "Wild ARMs 3",
+};
+
+// Returns monotonic time in microseconds
+static int64_t getTime() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Calculates line width by scanning font buckets and kerning lists directly
+static int getReferenceLineWidth(const char *text) {
+  int width = 0;
+  for (int i = 0; (text[i] != '\0') && (text[i] != '\n'); i++) {
+    uint32_t c = (uint8_t)text[i];
+    for (int b = 0; b < font.bucketCount; b++) {
+      const BMFontBucket *bucket = &font.buckets[b];
+      if ((c < bucket->startChar) || (c > bucket->endChar))
+        continue;
+
+      const BMFontChar *glyph = &bucket->chars[c - bucket->startChar];
+      width += glyph->xadvance;
+      for (int k = 0; k < glyph->kerningsCount; k++) {
+        if (glyph->kernings[k].secondChar == (uint8_t)text[i + 1])
+          width += glyph->kernings[k].amount;
+      }
+      break;
+    }
+  }
+  return width;
+}
+
+// Lays out the text of the title list page
+static void layoutFrame(int selectedIdx) {
+  char lineBuffer[64];
+  int baseX = 20;
+  int coverArtX1 = gsGlobal->Width - 150 - 140;
+
+  drawTextWindow(baseX, 40, gsGlobal->Width - baseX, 0, 0, 0, ALIGN_HCENTER, "Title List");
+  snprintf(lineBuffer, sizeof(lineBuffer), "Page %d/%d\nTitle %d/%d", 1, 1, selectedIdx + 1, TITLES_PER_PAGE);
+  drawTextWindow(baseX, 40, gsGlobal->Width - baseX, 0, 0, 0, ALIGN_RIGHT, lineBuffer);
+
+  int titleY = 70;
+  for (int i = 0; i < TITLES_PER_PAGE; i++)
+    titleY = drawText(baseX, titleY, 0, coverArtX1, 0, 0, titleNames[i]);
+
+  int y = drawTextWindow(coverArtX1, 330, coverArtX1 + 140, 0, 0, 0, ALIGN_HCENTER, "SLUS_200.02");
+  drawTextWindow(coverArtX1, y, coverArtX1 + 140, 0, 0, 0, ALIGN_HCENTER, "BDM");
+
+  int footerY = gsGlobal->Height - 30;
+  drawTextWindow(baseX + 40, footerY, 0, gsGlobal->Height, 0, 0, ALIGN_VCENTER, "Launch title");
+  drawTextWindow(5, footerY, gsGlobal->Width, gsGlobal->Height, 0, 0, ALIGN_CENTER, "Exit");
+  drawTextWindow(0, footerY, gsGlobal->Width - baseX, gsGlobal->Height, 0, 0, ALIGN_VCENTER | ALIGN_RIGHT, "Title options");
+  getLineWidth("Exit");
+  getLineWidth("Title options");
+}
+
+int main(int argc, char *argv[]) {
+  int frameCount = DEFAULT_FRAME_COUNT;
+  if (argc > 1) {
+    if ((argc > 2) || ((frameCount = atoi(argv[1])) <= 0)) {
+      fprintf(stderr, "Usage: %s [frame count]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if (initFont()) {
+    fprintf(stderr, "ERROR: Failed to initialize font\n");
+    return 1;
+  }
+
+  // Make sure kerning is applied the same way the font defines it
+  for (int i = 0; i < TITLES_PER_PAGE; i++) {
+    int expected = getReferenceLineWidth(titleNames[i]);
+    if ((int)getLineWidth(titleNames[i]) != expected) {
+      fprintf(stderr, "ERROR: Width of \"%s\" is %d instead of %d\n", titleNames[i], (int)getLineWidth(titleNames[i]), expected);
+      closeFont();
+      return 1;
+    }
+  }
+
+  spriteCount = 0;
+  getDrawStats();
+  layoutFrame(0);
+  int glyphsPerFrame = spriteCount;
+  DrawStats stats = getDrawStats();
+
+  int64_t start = getTime();
+  for (int i = 0; i < frameCount; i++)
+    layoutFrame(i % TITLES_PER_PAGE);
+  int64_t elapsed = getTime() - start;
+  closeFont();
+
+  printf("Text layout: %d frames, %d glyphs per frame\n", frameCount, glyphsPerFrame);
+  printf("%10d GS primitives per frame\n%10d queue bytes per frame\n", stats.primitives, stats.bytes);
+  printf("%10.2f us per frame\n%10.2f ns per glyph\n", (double)elapsed / frameCount, elapsed * 1000.0 / ((double)frameCount * glyphsPerFrame));
+  return 0;
+}
@@ -0,0 +1,108 @@
+// Generates synthetic trees of minimal PS2 ISO images
+#include "iso_generator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SECTOR_SIZE 2048
+#define PVD_LBA 16
+#define TERMINATOR_LBA 17
+#define ROOT_DIR_LBA 18
+#define SYSTEM_CNF_LBA 19
+#define ISO_SECTORS 20
+
+// Writes 32-bit value in both-endian format
+static void writeBothEndian32(uint8_t *buf, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    buf[i] = (value >> (i * 8)) & 0xFF;
+    buf[7 - i] = (value >> (i * 8)) & 0xFF;
+  }
+}
+
+// Writes ISO 9660 directory record and returns record length
+static int writeDirRecord(uint8_t *buf, const char *name, int nameLength, uint32_t lba, uint32_t size, int isDirectory) {
+  int length = 33 + nameLength;
+  length += length & 1; // Records are padded to even length
+
+  memset(buf, 0, length);
+  buf[0] = length;
+  writeBothEndian32(&buf[2], lba);
+  writeBothEndian32(&buf[10], size);
+  buf[25] = (isDirectory) ? 0x02 : 0x00;
+  buf[28] = 1; // Volume sequence number
+  buf[31] = 1;
+  buf[32] = nameLength;
+  memcpy(&buf[33], name, nameLength);
+  return length;
+}
+
+// Writes a minimal PS2 ISO image that contains PVD, root directory and SYSTEM.CNF with the given title ID
+int writeISO(const char *path, const char *titleID) {
+  uint8_t sectors[(ISO_SECTORS - PVD_LBA) * SECTOR_SIZE] = {0};
+  uint8_t *pvd = &sectors[(PVD_LBA - PVD_LBA) * SECTOR_SIZE];
+  uint8_t *terminator = &sectors[(TERMINATOR_LBA - PVD_LBA) * SECTOR_SIZE];
+  uint8_t *rootDir = &sectors[(ROOT_DIR_LBA - PVD_LBA) * SECTOR_SIZE];
+  char *systemCNF = (char *)&sectors[(SYSTEM_CNF_LBA - PVD_LBA) * SECTOR_SIZE];
+
+  int cnfSize = snprintf(systemCNF, SECTOR_SIZE, "BOOT2 = cdrom0:\\%s;1\r\nVER = 1.00\r\nVMODE = NTSC\r\n", titleID);
+
+  // Primary Volume Descriptor with root directory record
+  pvd[0] = 1;
+  memcpy(&pvd[1], "CD001", 5);
+  pvd[6] = 1;
+  writeBothEndian32(&pvd[80], ISO_SECTORS);
+  writeDirRecord(&pvd[0x9c], "\0", 1, ROOT_DIR_LBA, SECTOR_SIZE, 1);
+
+  // Volume Descriptor Set Terminator
+  terminator[0] = 0xFF;
+  memcpy(&terminator[1], "CD001", 5);
+  terminator[6] = 1;
+
+  // Root directory: current directory, parent directory and SYSTEM.CNF
+  int offset = writeDirRecord(rootDir, "\0", 1, ROOT_DIR_LBA, SECTOR_SIZE, 1);
+  offset += writeDirRecord(&rootDir[offset], "\1", 1, ROOT_DIR_LBA, SECTOR_SIZE, 1);
+  writeDirRecord(&rootDir[offset], "SYSTEM.CNF;1", 12, SYSTEM_CNF_LBA, cnfSize, 0);
+
+  // Leave system area as a hole to keep images sparse
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return -errno;
+
+  int res = 0;
+  if ((ftruncate(fd, ISO_SECTORS * SECTOR_SIZE) < 0) || (pwrite(fd, sectors, sizeof(sectors), PVD_LBA * SECTOR_SIZE) != sizeof(sectors)))
+    res = -errno;
+
+  close(fd);
+  return res;
+}
+
+// Generates count ISO images in DVD subdirectories of root, putting up to titlesPerDirectory images in each directory.
+// Title names are generated in pseudo-random order
+int generateISOTree(const char *root, int count, int titlesPerDirectory) {
+  char path[4096];
+  char titleID[12];
+
+  snprintf(path, sizeof(path), "%s/DVD", root);
+  if ((mkdir(root, 0755) && (errno != EEXIST)) || (mkdir(path, 0755) && (errno != EEXIST)))
+    return -errno;
+
+  int res;
+  for (int i = 0; i < count; i++) {
+    if ((i % titlesPerDirectory) == 0) {
+      snprintf(path, sizeof(path), "%s/DVD/Group %04d", root, i / titlesPerDirectory);
+      if (mkdir(path, 0755) && (errno != EEXIST))
+        return -errno;
+    }
+
+    // Multiplying by an odd constant produces unique names in scrambled order
+    snprintf(path, sizeof(path), "%s/DVD/Group %04d/Title %08X.iso", root, i / titlesPerDirectory, (uint32_t)i * 2654435761u);
+    snprintf(titleID, sizeof(titleID), "SLUS_%03d.%02d", (i / 100) % 1000, i % 100);
+    if ((res = writeISO(path, titleID)))
+      return res;
+  }
+  return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef _ISO_GENERATOR_H_
+#define _ISO_GENERATOR_H_
+
+// Writes a minimal PS2 ISO image that contains PVD, root directory and SYSTEM.CNF with the given title ID
+int writeISO(const char *path, const char *titleID);
+
+// Generates count ISO images in DVD subdirectories of root, putting up to titlesPerDirectory images in each directory.
+// Title names are generated in pseudo-random order
+int generateISOTree(const char *root, int count, int titlesPerDirectory);
+
+#endif
@@ -0,0 +1,5 @@
+// Host shim for dmaKit. Nothing is used by the benchmarked modules
+#ifndef _BENCH_DMAKIT_H_
+#define _BENCH_DMAKIT_H_
+
+#endif
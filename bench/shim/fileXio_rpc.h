@@ -0,0 +1,17 @@
+// Host shim for fileXio RPC calls, implemented with POSIX file I/O
+#ifndef _BENCH_FILEXIO_RPC_H_
+#define _BENCH_FILEXIO_RPC_H_
+
+#include <iox_stat.h>
+#include <stdint.h>
+
+int fileXioOpen(const char *path, int flags, ...);
+int fileXioClose(int fd);
+int fileXioRead(int fd, void *buf, int size);
+int64_t fileXioLseek64(int fd, int64_t offset, int whence);
+int fileXioDopen(const char *path);
+int fileXioDclose(int fd);
+int fileXioDread(int fd, iox_dirent_t *dirent);
+int fileXioGetStat(const char *path, iox_stat_t *iox);
+
+#endif
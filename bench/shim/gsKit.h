@@ -0,0 +1,93 @@
+// Host shim for gsKit.
+// Only the types and functions used by the benchmarked GUI modules are provided
+#ifndef _BENCH_GSKIT_H_
+#define _BENCH_GSKIT_H_
+
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef struct {
+  int Width;
+  int Height;
+} GSGLOBAL;
+
+typedef struct {
+  u32 Width;
+  u32 Height;
+  u8 PSM;
+  u8 ClutPSM;
+  u8 TBW;
+  u32 *Mem;
+  u32 *Clut;
+  u32 Vram;
+  u32 VramClut;
+  u32 Filter;
+  u8 Delayed;
+} GSTEXTURE;
+
+typedef union {
+  u64 rgbaq;
+  struct {
+    u8 r;
+    u8 g;
+    u8 b;
+    u8 a;
+    float q;
+  };
+} gs_rgbaq;
+
+typedef union {
+  u64 xyz;
+  struct {
+    u16 x;
+    u16 y;
+    u32 z;
+  };
+} gs_xyz2;
+
+typedef union {
+  u64 uv;
+  struct {
+    u16 u;
+    u16 v;
+  };
+} gs_uv;
+
+typedef struct {
+  gs_xyz2 xyz2;
+  gs_uv uv;
+} GSPRIMUVPOINTFLAT;
+
+// Converts screen coordinates into 12.4 fixed point GS coordinates
+static inline gs_xyz2 vertex_to_XYZ2(const GSGLOBAL *gsGlobal, float fx, float fy, int iz) {
+  gs_xyz2 res = {.x = (u16)(fx * 16.0f), .y = (u16)(fy * 16.0f), .z = iz};
+  return res;
+}
+
+// Converts texel coordinates into 12.4 fixed point GS texture coordinates
+static inline gs_uv vertex_to_UV(const GSTEXTURE *texture, float u, float v) {
+  gs_uv res = {.u = (u16)(u * 16.0f), .v = (u16)(v * 16.0f)};
+  return res;
+}
+
+#define GS_SETREG_ALPHA(A, B, C, D, FIX) ((u64)(A) | ((u64)(B) << 2) | ((u64)(C) << 4) | ((u64)(D) << 6) | ((u64)(FIX) << 32))
+#define GS_BLEND_BACK2FRONT GS_SETREG_ALPHA(0, 1, 0, 1, 0)
+#define GS_ATEST_ON 1
+#define GS_ATEST_OFF 2
+#define GS_PSM_CT32 0x00
+#define GS_FILTER_NEAREST 0
+
+void gsKit_set_primalpha(GSGLOBAL *gsGlobal, u64 alpha, u8 perContext);
+void gsKit_set_test(GSGLOBAL *gsGlobal, u8 preset);
+void gsKit_prim_sprite_texture(GSGLOBAL *gsGlobal, const GSTEXTURE *texture, float x1, float y1, float u1, float v1, float x2, float y2,
+                               float u2, float v2, int iz, u64 color);
+void gsKit_prim_list_sprite_texture_uv_flat_color(GSGLOBAL *gsGlobal, const GSTEXTURE *texture, gs_rgbaq color, int count,
+                                                  const GSPRIMUVPOINTFLAT *vertices);
+unsigned int gsKit_TexManager_bind(GSGLOBAL *gsGlobal, GSTEXTURE *texture);
+u32 gsKit_texture_size_ee(int width, int height, int psm);
+
+#endif
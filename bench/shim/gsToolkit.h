@@ -0,0 +1,5 @@
+// Host shim for gsToolkit. Nothing is used by the benchmarked modules
+#ifndef _BENCH_GSTOOLKIT_H_
+#define _BENCH_GSTOOLKIT_H_
+
+#endif
@@ -0,0 +1,25 @@
+// Host implementations of gsKit functions used by the benchmarked GUI modules.
+// Drawing functions only count submitted primitives
+#include <gsKit.h>
+
+// Number of textured sprites submitted since the counter was reset
+int spriteCount;
+
+void gsKit_set_primalpha(GSGLOBAL *gsGlobal, u64 alpha, u8 perContext) {}
+
+void gsKit_set_test(GSGLOBAL *gsGlobal, u8 preset) {}
+
+void gsKit_prim_sprite_texture(GSGLOBAL *gsGlobal, const GSTEXTURE *texture, float x1, float y1, float u1, float v1, float x2, float y2,
+                               float u2, float v2, int iz, u64 color) {
+  spriteCount++;
+}
+
+void gsKit_prim_list_sprite_texture_uv_flat_color(GSGLOBAL *gsGlobal, const GSTEXTURE *texture, gs_rgbaq color, int count,
+                                                  const GSPRIMUVPOINTFLAT *vertices) {
+  // Each sprite is defined by two vertices
+  spriteCount += count / 2;
+}
+
+unsigned int gsKit_TexManager_bind(GSGLOBAL *gsGlobal, GSTEXTURE *texture) { return 0; }
+
+u32 gsKit_texture_size_ee(int width, int height, int psm) { return width * height * 4; }
@@ -0,0 +1,7 @@
+// Host shim for iomanX file flags
+#ifndef _BENCH_IO_COMMON_H_
+#define _BENCH_IO_COMMON_H_
+
+#define FIO_O_RDONLY 0x0001
+
+#endif
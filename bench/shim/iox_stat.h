@@ -0,0 +1,34 @@
+// Host shim for iomanX stat structures
+#ifndef _BENCH_IOX_STAT_H_
+#define _BENCH_IOX_STAT_H_
+
+typedef struct {
+  unsigned int mode;
+  unsigned int attr;
+  unsigned int size;
+  unsigned char ctime[8];
+  unsigned char atime[8];
+  unsigned char mtime[8];
+  unsigned int hisize;
+  unsigned int private_0;
+  unsigned int private_1;
+  unsigned int private_2;
+  unsigned int private_3;
+  unsigned int private_4;
+  unsigned int private_5;
+} iox_stat_t;
+
+typedef struct {
+  iox_stat_t stat;
+  char name[256];
+  void *unknown;
+} iox_dirent_t;
+
+#define FIO_S_IFMT 0xF000
+#define FIO_S_IFREG 0x2000
+#define FIO_S_IFDIR 0x1000
+
+#define FIO_S_ISREG(m) (((m) & FIO_S_IFMT) == FIO_S_IFREG)
+#define FIO_S_ISDIR(m) (((m) & FIO_S_IFMT) == FIO_S_IFDIR)
+
+#endif
@@ -0,0 +1,57 @@
+// Host shim for EE kernel threads and semaphores, implemented with POSIX threads
+#ifndef _BENCH_KERNEL_H_
+#define _BENCH_KERNEL_H_
+
+#include <stdint.h>
+
+typedef struct {
+  int status;
+  void *func;
+  void *stack;
+  int stack_size;
+  void *gp_reg;
+  int initial_priority;
+  uint32_t attr;
+  uint32_t option;
+} ee_thread_t;
+
+typedef struct {
+  int status;
+  void *func;
+  void *stack;
+  int stack_size;
+  void *gp_reg;
+  int initial_priority;
+  int current_priority;
+  uint32_t attr;
+  uint32_t option;
+  uint32_t waitType;
+  uint32_t waitId;
+  uint32_t wakeupCount;
+} ee_thread_status_t;
+
+typedef struct {
+  int count;
+  int max_count;
+  int init_count;
+  int wait_threads;
+  uint32_t attr;
+  uint32_t option;
+} ee_sema_t;
+
+int CreateThread(ee_thread_t *thread);
+int StartThread(int threadID, void *arg);
+void ExitThread();
+int TerminateThread(int threadID);
+int DeleteThread(int threadID);
+int GetThreadId();
+int ReferThreadStatus(int threadID, ee_thread_status_t *status);
+int DelayThread(int microseconds);
+
+int CreateSema(ee_sema_t *sema);
+int DeleteSema(int semaID);
+int WaitSema(int semaID);
+int SignalSema(int semaID);
+int PollSema(int semaID);
+
+#endif
@@ -0,0 +1,23 @@
+// Host shim for libcdvd clock functions
+#ifndef _BENCH_LIBCDVD_H_
+#define _BENCH_LIBCDVD_H_
+
+#define SCECdINoD 0x00
+#define SCECdEXIT 0x05
+
+typedef struct {
+  unsigned char stat;
+  unsigned char second;
+  unsigned char minute;
+  unsigned char hour;
+  unsigned char pad;
+  unsigned char day;
+  unsigned char month;
+  unsigned char year;
+} sceCdCLOCK;
+
+int sceCdInit(int mode);
+int sceCdReadClock(sceCdCLOCK *clock);
+int btoi(int bcd);
+
+#endif
@@ -0,0 +1,16 @@
+// Host shim for ps2sdkapi.h.
+// Provides POSIX headers that ps2sdk makes available to EE code
+#ifndef _BENCH_PS2SDKAPI_H_
+#define _BENCH_PS2SDKAPI_H_
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+size_t strlcpy(char *dst, const char *src, size_t size);
+
+#endif
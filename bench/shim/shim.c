@@ -0,0 +1,267 @@
+// Host implementations of ps2sdk functions and NHDDL globals used by the benchmarked modules.
+// BDM mountpoints (massX:) are regular directories relative to the current working directory.
+#include "common.h"
+#include "devices.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <fileXio_rpc.h>
+#include <kernel.h>
+#include <libcdvd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_THREADS 32
+#define MAX_SEMAS 32
+#define MAX_DIRS 32
+
+// Globals normally defined by main.c and devices.c
+DeviceMapEntry deviceModeMap[MAX_MASS_DEVICES];
+LauncherOptions LAUNCHER_OPTIONS;
+char ELF_BASE_PATH[PATH_MAX + 1];
+char NEUTRINO_ELF_PATH[PATH_MAX + 1];
+void *_gp;
+
+// Set to 0 to suppress logString output
+int isLogEnabled = 1;
+
+// Logs to stdout
+void logString(const char *str, ...) {
+  if (!isLogEnabled)
+    return;
+
+  va_list args;
+  va_start(args, str);
+  vprintf(str, args);
+  va_end(args);
+}
+
+// Maps ModeType to string
+char *modeToString(ModeType mode) { return (mode == MODE_ALL) ? "Unknown" : "BDM"; }
+
+size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t toCopy = (length >= size) ? size - 1 : length;
+    memcpy(dst, src, toCopy);
+    dst[toCopy] = '\0';
+  }
+  return length;
+}
+
+//
+// Threads
+//
+
+typedef struct {
+  int isUsed;
+  ee_thread_t params;
+  void *arg;
+  pthread_t thread;
+} ShimThread;
+
+static ShimThread threads[MAX_THREADS];
+static pthread_mutex_t threadMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void *threadEntry(void *arg) {
+  ShimThread *thread = arg;
+  ((void (*)(void *))thread->params.func)(thread->arg);
+  return NULL;
+}
+
+int CreateThread(ee_thread_t *params) {
+  pthread_mutex_lock(&threadMutex);
+  // Thread ID 0 is reserved for the main thread
+  for (int i = 1; i < MAX_THREADS; i++) {
+    if (!threads[i].isUsed) {
+      threads[i].isUsed = 1;
+      threads[i].params = *params;
+      pthread_mutex_unlock(&threadMutex);
+      return i;
+    }
+  }
+  pthread_mutex_unlock(&threadMutex);
+  return -1;
+}
+
+int StartThread(int threadID, void *arg) {
+  threads[threadID].arg = arg;
+  if (pthread_create(&threads[threadID].thread, NULL, threadEntry, &threads[threadID]))
+    return -1;
+  return 0;
+}
+
+void ExitThread() { pthread_exit(NULL); }
+
+// Threads can't be terminated safely, DeleteThread waits for the thread to exit instead
+int TerminateThread(int threadID) { return 0; }
+
+int DeleteThread(int threadID) {
+  pthread_join(threads[threadID].thread, NULL);
+  pthread_mutex_lock(&threadMutex);
+  threads[threadID].isUsed = 0;
+  pthread_mutex_unlock(&threadMutex);
+  return 0;
+}
+
+int GetThreadId() {
+  pthread_t self = pthread_self();
+  for (int i = 1; i < MAX_THREADS; i++) {
+    if (threads[i].isUsed && pthread_equal(threads[i].thread, self))
+      return i;
+  }
+  return 0;
+}
+
+int ReferThreadStatus(int threadID, ee_thread_status_t *status) {
+  memset(status, 0, sizeof(ee_thread_status_t));
+  status->current_priority = (threadID) ? threads[threadID].params.initial_priority : 64;
+  return 0;
+}
+
+int DelayThread(int microseconds) { return usleep(microseconds); }
+
+//
+// Semaphores
+//
+
+static sem_t semas[MAX_SEMAS];
+static int isSemaUsed[MAX_SEMAS];
+static pthread_mutex_t semaMutex = PTHREAD_MUTEX_INITIALIZER;
+
+int CreateSema(ee_sema_t *sema) {
+  pthread_mutex_lock(&semaMutex);
+  for (int i = 0; i < MAX_SEMAS; i++) {
+    if (!isSemaUsed[i]) {
+      isSemaUsed[i] = 1;
+      sem_init(&semas[i], 0, sema->init_count);
+      pthread_mutex_unlock(&semaMutex);
+      return i;
+    }
+  }
+  pthread_mutex_unlock(&semaMutex);
+  return -1;
+}
+
+int DeleteSema(int semaID) {
+  sem_destroy(&semas[semaID]);
+  pthread_mutex_lock(&semaMutex);
+  isSemaUsed[semaID] = 0;
+  pthread_mutex_unlock(&semaMutex);
+  return semaID;
+}
+
+int WaitSema(int semaID) {
+  while (sem_wait(&semas[semaID])) {
+    if (errno != EINTR)
+      return -1;
+  }
+  return semaID;
+}
+
+int SignalSema(int semaID) { return sem_post(&semas[semaID]) ? -1 : semaID; }
+
+int PollSema(int semaID) { return sem_trywait(&semas[semaID]) ? -1 : semaID; }
+
+//
+// fileXio
+//
+
+int fileXioOpen(const char *path, int flags, ...) {
+  int fd = open(path, O_RDONLY);
+  return (fd < 0) ? -errno : fd;
+}
+
+int fileXioClose(int fd) { return close(fd); }
+
+int fileXioRead(int fd, void *buf, int size) {
+  int res = read(fd, buf, size);
+  return (res < 0) ? -errno : res;
+}
+
+int64_t fileXioLseek64(int fd, int64_t offset, int whence) {
+  off_t res = lseek(fd, offset, whence);
+  return (res < 0) ? -errno : res;
+}
+
+// Fills iox stat fields used by NHDDL from POSIX stat
+static void fillIOXStat(iox_stat_t *iox, struct stat *st) {
+  struct tm tm;
+  memset(iox, 0, sizeof(iox_stat_t));
+  iox->mode = S_ISDIR(st->st_mode) ? FIO_S_IFDIR : FIO_S_IFREG;
+  iox->size = (uint64_t)st->st_size & 0xFFFFFFFF;
+  iox->hisize = (uint64_t)st->st_size >> 32;
+
+  // Modification time is stored as unused byte, seconds, minutes, hours, day, month and little-endian year
+  localtime_r(&st->st_mtime, &tm);
+  iox->mtime[1] = tm.tm_sec;
+  iox->mtime[2] = tm.tm_min;
+  iox->mtime[3] = tm.tm_hour;
+  iox->mtime[4] = tm.tm_mday;
+  iox->mtime[5] = tm.tm_mon + 1;
+  iox->mtime[6] = (tm.tm_year + 1900) & 0xFF;
+  iox->mtime[7] = (tm.tm_year + 1900) >> 8;
+}
+
+int fileXioGetStat(const char *path, iox_stat_t *iox) {
+  struct stat st;
+  if (stat(path, &st))
+    return -errno;
+
+  fillIOXStat(iox, &st);
+  return 0;
+}
+
+// Directory descriptors are indexes in dirs
+static DIR *dirs[MAX_DIRS];
+
+int fileXioDopen(const char *path) {
+  for (int i = 0; i < MAX_DIRS; i++) {
+    if (dirs[i] == NULL) {
+      if ((dirs[i] = opendir(path)) == NULL)
+        return -errno;
+      return i;
+    }
+  }
+  return -EMFILE;
+}
+
+int fileXioDclose(int fd) {
+  closedir(dirs[fd]);
+  dirs[fd] = NULL;
+  return 0;
+}
+
+// Returns 1 if an entry has been read, 0 at the end of the directory or a negative error
+int fileXioDread(int fd, iox_dirent_t *dirent) {
+  struct dirent *entry;
+  struct stat st;
+  memset(dirent, 0, sizeof(iox_dirent_t));
+  while ((entry = readdir(dirs[fd])) != NULL) {
+    if (fstatat(dirfd(dirs[fd]), entry->d_name, &st, 0))
+      continue;
+
+    fillIOXStat(&dirent->stat, &st);
+    strlcpy(dirent->name, entry->d_name, sizeof(dirent->name));
+    return 1;
+  }
+  return 0;
+}
+
+//
+// libcdvd
+//
+
+int sceCdInit(int mode) { return 1; }
+
+int sceCdReadClock(sceCdCLOCK *clock) {
+  memset(clock, 0, sizeof(sceCdCLOCK));
+  return 1;
+}
+
+int btoi(int bcd) { return ((bcd >> 4) * 10) + (bcd & 0xF); }
@@ -0,0 +1,41 @@
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+// Arena memory block
+typedef struct ArenaBlock {
+  struct ArenaBlock *next; // Next block
+  size_t size;             // Usable block size
+  size_t used;             // Number of used bytes
+} __attribute__((aligned(8))) ArenaBlock; // Aligned to keep block data aligned
+
+// Bump allocator that carves allocations from large memory blocks.
+// Allocations can't be freed individually, all memory is released at once by arenaFree.
+typedef struct {
+  ArenaBlock *head; // Current block
+  size_t blockSize; // Default block size
+  size_t used;      // Total number of used bytes
+  size_t allocated; // Total number of bytes allocated for blocks
+  int blockCount;   // Total number of blocks
+} Arena;
+
+// Initializes the arena. Blocks will be allocated on demand.
+void arenaInit(Arena *arena, size_t blockSize);
+
+// Allocates zeroed memory aligned to 8 bytes
+void *arenaAlloc(Arena *arena, size_t size);
+
+// Copies null-terminated string into the arena
+char *arenaStrdup(Arena *arena, const char *str);
+
+// Copies up to len characters of str into the arena, always null-terminating the copy
+char *arenaStrndup(Arena *arena, const char *str, size_t len);
+
+// Moves all blocks from src to dst. src will be empty after this function executes
+void arenaMerge(Arena *dst, Arena *src);
+
+// Frees all memory used by the arena
+void arenaFree(Arena *arena);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _ART_INDEX_H_
+#define _ART_INDEX_H_
+
+#include <stdint.h>
+
+// Cover art directory path relative to storage device mountpoint
+#define ART_DIRECTORY "/ART"
+// Cover art file name suffix
+#define COVER_ART_SUFFIX "_COV.png"
+
+// Returns the number of the device that has cover art for titleID, preferring preferredDevice.
+// If size is not NULL, it's set to the size of the cover art file on the returned device.
+// ART directories of all devices are read once on the first call.
+// Returns -1 if cover art for titleID doesn't exist
+int findCoverArtDevice(const char *titleID, int preferredDevice, uint32_t *size);
+
+// Frees memory used by the cover art index
+void freeCoverArtIndex();
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef _COMMON_H_
 #define _COMMON_H_
 
+#include "scan_filter.h"
 #include <ps2sdkapi.h>
 
 // Enum for supported modes
@@ -18,6 +19,7 @@ typedef struct {
   int is480pEnabled;
   ModeType mode;
   char udpbdIp[16];
+  ScanFilter scanFilter; // Directories to scan and exclude
 } LauncherOptions;
 
 // ELF base path. Initialized in main() during init.
@@ -0,0 +1,27 @@
+#ifndef _COVER_CACHE_H_
+#define _COVER_CACHE_H_
+
+#include "iso.h"
+#include <gsKit.h>
+
+// Number of decoded covers kept in EE RAM
+#define COVER_CACHE_SIZE 16
+// Number of titles before and after the selected title that have their covers prefetched
+#define COVER_PREFETCH_RADIUS 3
+
+// Starts the cover loader thread
+int initCoverCache(GSGLOBAL *gsGlobal);
+
+// Stops the cover loader thread and frees all decoded covers
+void closeCoverCache();
+
+// Requests covers for the selected title, its neighbours and titles one page away.
+// Covers are decoded in the background, starting from the selected title
+void setCoverArtFocus(TargetList *titles, int selectedIdx, int pageSize);
+
+// Fills texture with the decoded cover for titleID without blocking.
+// The cover stays in memory until another cover is returned.
+// Returns 0 if the cover is ready, -EAGAIN if it's still being loaded or -ENOENT if the title has no cover
+int getCoverArt(const char *titleID, GSTEXTURE *texture);
+
+#endif
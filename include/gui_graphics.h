@@ -1,6 +1,8 @@
 #ifndef _BMFONT_H_
 #define _BMFONT_H_
 
+#include <gsKit.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define ALIGN_LEFT 0 << 0
@@ -25,6 +27,12 @@ typedef enum {
   ICON_ENABLED
 } IconType;
 
+// Number of GS primitives and GIF packet bytes queued by font and icon drawing functions
+typedef struct {
+  int primitives;
+  int bytes;
+} DrawStats;
+
 int initFont();
 
 // Draws the text with specified max dimensions relative to x and y
@@ -58,4 +66,11 @@ void drawIcon(float x, float y, int z, uint64_t color, IconType iconType);
 // Draws the icon in [x1,y1],[x2,y2] window.
 void drawIconWindow(int x1, int y1, int x2, int y2, int z, uint64_t color, uint8_t alignment, IconType iconType);
 
+// Returns the number of GS primitives and GIF packet bytes queued by font and icon drawing functions since the last call
+DrawStats getDrawStats();
+
+// Decodes PNG texture from memory into a CT32 GSTEXTURE and uploads it to GS VRAM unless the texture is delayed.
+// PNG alpha is converted into the inverted GS range, where 0 is fully opaque and 0x80 is fully transparent
+int gsKit_texture_png_mem(GSGLOBAL *gsGlobal, GSTEXTURE *texture, void *buf, size_t size);
+
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef _ISO_H_
 #define _ISO_H_
 
+#include "arena.h"
 #include "common.h"
 #include <stdint.h>
 
@@ -9,33 +10,49 @@ typedef struct Target {
   uint16_t idx;        // ISO index (monotonically increasing). Used to uniquely identify the list entry
   char *fullPath;      // Full path to ISO
   char *name;          // Target name (extracted from file name)
-  char *id;            // Title ID
+  char *id;            // Title ID. NULL while pending, empty if ISO doesn't have a valid title ID
+  uint64_t size;       // ISO size
   ModeType deviceType; // Device type
 
   struct Target *prev; // Previous target in the list
   struct Target *next; // Next target in the list
 } Target;
 
-// A linked list of launch candidates
+// A list of launch candidates.
+// Targets can be accessed by index using the targets array or traversed as a linked list.
 typedef struct {
-  int total;     // Total number of targets
-  Target *first; // First target
-  Target *last;  // Last target
+  int total;        // Total number of targets
+  Target **targets; // Array of targets indexed by Target->idx
+  Target *first;    // First target
+  Target *last;     // Last target
+  Arena arena;      // Arena used to allocate targets and their strings
 } TargetList;
 
-// Generates a list of launch candidates found on BDM devices
+// Generates a list of launch candidates found on BDM devices.
+// If the target list snapshot is available, it's returned right away and validated in the background.
+// Title IDs missing from the title ID cache are resolved in the background
 TargetList *findISO();
 
+// Sets the index of the title currently selected in the UI.
+// Title IDs of targets around this index are resolved first.
+void setTitleIDFocus(TargetList *list, int idx);
+
+// Waits until the title ID for the target is resolved.
+// Returns 0 if target has a valid title ID
+int waitForTitleID(TargetList *list, Target *target);
+
+// Replaces list contents with the up-to-date list once the background validation of the
+// target list snapshot is done. selectedIdx is updated to point to the same title in the new list.
+// Returns 1 if the list has been replaced. All pointers to list targets are invalid in this case
+int updateTargetList(TargetList *list, int *selectedIdx);
+
 // Completely frees TargetList. Passed pointer will not be valid after this function executes
 void freeTargetList(TargetList *result);
 
-// Finds target with given index in the list and returns a pointer to it
+// Returns a pointer to target with given index or NULL if index is out of bounds
 Target *getTargetByIdx(TargetList *targets, int idx);
 
 // Makes and returns a deep copy of src without prev/next pointers.
 Target *copyTarget(Target *src);
 
-// Completely frees Target and returns pointer to a previous argument in the list
-Target *freeTarget(Target *target);
-
 #endif
@@ -2,29 +2,129 @@
 #define _TITLE_CACHE_H_
 
 #include "iso.h"
+#include <stdint.h>
+
+// Current title ID cache file version
+#define TITLE_ID_CACHE_VERSION 3
 
 typedef struct {
-  char titleID[12];
-  char *fullPath;
+  char *titleID;  // Title ID. Empty if the ISO doesn't have a valid title ID
+  char *fullPath; // ISO path without the mountpoint
+  uint64_t size;  // ISO size. 0 if cache was migrated from a version without file sizes
+  int device;     // Device number. -1 if cache was migrated from a version without per-device files
 } CacheEntry;
 
 typedef struct TitleIDCache {
+  int version;         // Oldest version among the loaded cache files
   int total;           // Total number of elements in cache
-  int lastMatchedIdx;  // Used to skip ahead to the last matched entry when getting title ID from cache
   CacheEntry *entries; // Pointer to cache entry array
+
+  int indexSize; // Number of hash index slots, always a power of two
+  int *index;    // Open-addressing hash index of entries keyed by path. Stores entry index + 1, 0 marks an empty slot
+  char *data;    // Cache file contents followed by entry array and hash index. Entries point into this buffer
+
+  int hits;   // Number of successful lookups
+  int misses; // Number of failed lookups, including stale entries
+  int stale;  // Number of entries that matched the path but not the ISO size
+  int probes; // Total number of hash index slots examined by lookups
 } TitleIDCache;
 
-// Saves TargetList into title ID cache
+// Saves TargetList into title ID cache.
+// Every device stores only its own titles and unchanged cache files are not rewritten
 int storeTitleIDCache(TargetList *list);
 
-// Loads title ID cache from storage into cache
+// Loads title ID cache from every storage device into cache
 int loadTitleIDCache(TitleIDCache *cache);
 
 // Returns a pointer to title ID or NULL if path doesn't exist in cache
-char *getCachedTitleID(char *fullPath, TitleIDCache *cache);
+// or the cached ISO size doesn't match size. Title ID is empty if the ISO doesn't have a valid title ID
+char *getCachedTitleID(char *fullPath, uint64_t size, TitleIDCache *cache);
 
 // Frees memory used by title ID cache
 // All pointers to cache entries (including title IDs) will be invalid
 void freeTitleCache(TitleIDCache *cache);
 
+// Saves the complete target list into the target list snapshot on the first storage device.
+// All targets must have a title ID. The file is not rewritten if its contents haven't changed
+int storeTargetListSnapshot(TargetList *list);
+
+// Loads target list snapshot into an empty list, allocating targets and strings from the list arena.
+// Fails if the set of storage devices has changed since the snapshot was saved
+int loadTargetListSnapshot(TargetList *list);
+
+// Directory cache record types
+#define DIR_CACHE_FILE 'f' // ISO file
+#define DIR_CACHE_DIR 'd'  // Subdirectory
+
+// Directory cache record.
+// Followed by null-terminated directory path (without the mountpoint) and nameCount entries,
+// each stored as an entry type byte followed by null-terminated entry name.
+// File entries are followed by the file size stored as unaligned uint64_t,
+// directory entries are followed by the directory modification time stored as unaligned uint32_t.
+// Records are padded to 4 bytes.
+typedef struct {
+  uint32_t size;       // Record size, including header and padding
+  uint32_t mtime;      // Directory modification time. 0 if not available
+  uint32_t pathHash;   // Hash of directory path, used to look up records
+  uint16_t nameCount;  // Number of entries stored in the record
+  uint16_t pathLength; // Length of directory path, including null terminator
+} DirCacheRecord;
+
+// Maximum time in seconds between scans that read all directories.
+// Some filesystems (FAT in particular) don't always update directory modification time when files are added,
+// so directories can't be reused from the cache indefinitely
+#define DIR_CACHE_FULL_READ_INTERVAL (24 * 60 * 60)
+
+// Per-device cache of scanned directories
+typedef struct {
+  uint32_t fullReadTime; // Time of the last scan that read all directories. 0 if not known
+  int total;             // Total number of records
+  int size;              // Size of record data
+  int capacity;          // Allocated size of record data
+  uint32_t *offsets;     // Record offsets. Only initialized for loaded caches
+  int indexSize;         // Number of hash index slots, always a power of two. Only initialized for loaded caches
+  int *index;            // Open-addressing hash index of records keyed by path. Stores record index + 1, 0 marks an empty slot
+  char *data;            // Record data
+} DirectoryCache;
+
+// Loads directory cache from the device at mountpoint
+int loadDirectoryCache(DirectoryCache *cache, const char *mountpoint);
+
+// Saves directory cache to the device at mountpoint
+int storeDirectoryCache(DirectoryCache *cache, const char *mountpoint);
+
+// Returns a pointer to cached directory record or NULL if path is not cached
+// or modification time is not available or doesn't match
+DirCacheRecord *getCachedDirectory(DirectoryCache *cache, const char *path, uint32_t mtime);
+
+// Starts a new record for the directory at path and returns its offset or a negative error
+int beginDirectoryRecord(DirectoryCache *cache, const char *path, uint32_t mtime);
+
+// Appends an entry to the record at offset. size is ignored for directories and mtime is ignored for files
+int appendDirectoryRecordEntry(DirectoryCache *cache, int offset, char type, const char *name, uint64_t size, uint32_t mtime);
+
+// Returns a pointer to the record entry following entry
+char *getNextDirectoryRecordEntry(char *entry);
+
+// Returns file size stored in the file record entry
+uint64_t getDirectoryRecordEntrySize(char *entry);
+
+// Returns directory modification time stored in the directory record entry
+uint32_t getDirectoryRecordEntryMtime(char *entry);
+
+// Finalizes the record at offset
+void endDirectoryRecord(DirectoryCache *cache, int offset);
+
+// Copies the record into cache and returns its offset or a negative error
+int copyDirectoryRecord(DirectoryCache *cache, DirCacheRecord *record);
+
+// Returns a pointer to the record at offset
+DirCacheRecord *getDirectoryRecord(DirectoryCache *cache, int offset);
+
+// Returns 1 if both caches contain the same records and full read time
+int isDirectoryCacheEqual(DirectoryCache *cache1, DirectoryCache *cache2);
+
+// Frees memory used by directory cache contents
+void freeDirectoryCache(DirectoryCache *cache);
+
 #endif
@@ -1,17 +1,42 @@
 #ifndef _PAD_H_
 #define _PAD_H_
 
-// Initializes gamepad input driver
-void initPad();
+// Delay before a held button starts repeating, in milliseconds
+#define PAD_REPEAT_DELAY 400
+// Interval between the first two repeats, in milliseconds
+#define PAD_REPEAT_INTERVAL 150
+// Repeat interval decrease after every repeat, in milliseconds
+#define PAD_REPEAT_ACCELERATION 10
+// Shortest repeat interval, in milliseconds
+#define PAD_REPEAT_MIN_INTERVAL 50
 
-// Closes gamepad gamepad input driver
+// Pad event types
+typedef enum {
+  PAD_EVENT_PRESS,   // Button has been pressed
+  PAD_EVENT_REPEAT,  // Button is being held
+  PAD_EVENT_RELEASE, // Button has been released
+} PadEventType;
+
+// Pad event
+typedef struct {
+  PadEventType type;
+  int button; // Single PAD_* button bit. Buttons of both gamepads are merged
+} PadEvent;
+
+// Initializes gamepad input driver and starts the thread that samples both gamepads on every vsync
+int initPad();
+
+// Stops the pad thread and closes gamepad input driver
 void closePad();
 
-// Blocks until input changes on any of the two gamepads.
-// To capture press of any button, pass -1.
-int waitForInput(int button);
+// Gets the next pad event without blocking.
+// Returns 1 if the event has been dequeued or 0 if there are no events
+int getPadEvent(PadEvent *event);
+
+// Blocks until the next pad event is available
+void waitForPadEvent(PadEvent *event);
 
-// Returns inputs on both gamepads
-int pollInput();
+// Discards all queued pad events
+void clearPadEvents();
 
 #endif
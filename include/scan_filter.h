@@ -0,0 +1,33 @@
+#ifndef _SCAN_FILTER_H_
+#define _SCAN_FILTER_H_
+
+// Compiled directory exclusion pattern
+typedef struct {
+  char *pattern;      // Uppercase pattern
+  int hasWildcards;   // Set if pattern contains '*' or '?'
+  int matchFullPath;  // Set if pattern contains '/' and must be matched against the full directory path
+} ScanPattern;
+
+// Restricts directories scanned for ISOs
+typedef struct {
+  int pathCount;         // Number of scan paths
+  char **paths;          // Directories to scan, relative to device root. If empty, the whole device is scanned
+  int patternCount;      // Number of exclusion patterns
+  ScanPattern *patterns; // Exclusion patterns
+} ScanFilter;
+
+// Adds directory to the list of directories to scan.
+// Path is relative to device root.
+int addScanPath(ScanFilter *filter, const char *path);
+
+// Compiles glob pattern and adds it to the list of exclusion patterns.
+// '*' matches any number of characters except '/', '?' matches any single character except '/'.
+// Patterns that contain '/' are matched against the full directory path relative to device root,
+// all other patterns are matched against the directory name. Matching is case-insensitive.
+int addScanExcludePattern(ScanFilter *filter, const char *pattern);
+
+// Returns 1 if directory must not be scanned.
+// path is the full directory path relative to device root, name is the directory name.
+int isDirectoryExcluded(ScanFilter *filter, const char *path, const char *name);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _VSYNC_H_
+#define _VSYNC_H_
+
+// Maximum number of semaphores signalled on vertical blank
+#define MAX_VSYNC_SEMAS 4
+
+// Installs the vertical blank interrupt handler
+int initVSync();
+
+// Removes the vertical blank interrupt handler and deletes all vsync semaphores
+void closeVSync();
+
+// Creates a semaphore that is signalled on every vertical blank.
+// Returns semaphore ID or a negative error
+int createVSyncSema();
+
+// Deletes the semaphore created by createVSyncSema
+void deleteVSyncSema(int semaID);
+
+// Puts the calling thread to sleep until the next vertical blank
+void waitForVSync(int semaID);
+
+#endif
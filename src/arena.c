@@ -0,0 +1,106 @@
+// Implements a simple block-based bump allocator
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 8
+
+// Allocates size bytes aligned to alignment
+static void *arenaAllocAligned(Arena *arena, size_t size, size_t alignment) {
+  ArenaBlock *block = arena->head;
+  if (block != NULL) {
+    uintptr_t base = (uintptr_t)(block + 1);
+    size_t offset = ((base + block->used + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + size <= block->size) {
+      arena->used += offset + size - block->used;
+      block->used = offset + size;
+      return (uint8_t *)(block + 1) + offset;
+    }
+  }
+
+  // Allocate a new block, making sure the allocation fits in it.
+  // Block header size is a multiple of 8, so the first allocation is always aligned.
+  size_t blockSize = arena->blockSize;
+  if (size > blockSize)
+    blockSize = size;
+
+  block = malloc(sizeof(ArenaBlock) + blockSize);
+  if (block == NULL)
+    return NULL;
+
+  block->size = blockSize;
+  block->used = size;
+  block->next = arena->head;
+  arena->head = block;
+  arena->used += size;
+  arena->allocated += sizeof(ArenaBlock) + blockSize;
+  arena->blockCount++;
+  return block + 1;
+}
+
+// Initializes the arena. Blocks will be allocated on demand.
+void arenaInit(Arena *arena, size_t blockSize) {
+  arena->head = NULL;
+  arena->blockSize = blockSize;
+  arena->used = 0;
+  arena->allocated = 0;
+  arena->blockCount = 0;
+}
+
+// Allocates zeroed memory aligned to 8 bytes
+void *arenaAlloc(Arena *arena, size_t size) {
+  void *ptr = arenaAllocAligned(arena, size, ARENA_ALIGNMENT);
+  if (ptr != NULL)
+    memset(ptr, 0, size);
+  return ptr;
+}
+
+// Copies null-terminated string into the arena
+char *arenaStrdup(Arena *arena, const char *str) { return arenaStrndup(arena, str, strlen(str)); }
+
+// Copies up to len characters of str into the arena, always null-terminating the copy
+char *arenaStrndup(Arena *arena, const char *str, size_t len) {
+  len = strnlen(str, len);
+  char *copy = arenaAllocAligned(arena, len + 1, 1);
+  if (copy == NULL)
+    return NULL;
+
+  memcpy(copy, str, len);
+  copy[len] = '\0';
+  return copy;
+}
+
+// Moves all blocks from src to dst. src will be empty after this function executes
+void arenaMerge(Arena *dst, Arena *src) {
+  if (src->head == NULL)
+    return;
+
+  if (dst->head == NULL) {
+    dst->head = src->head;
+  } else {
+    // Append dst blocks after src blocks to keep the current dst block on top
+    ArenaBlock *last = src->head;
+    while (last->next != NULL)
+      last = last->next;
+
+    last->next = dst->head->next;
+    dst->head->next = src->head;
+  }
+  dst->used += src->used;
+  dst->allocated += src->allocated;
+  dst->blockCount += src->blockCount;
+  arenaInit(src, src->blockSize);
+}
+
+// Frees all memory used by the arena
+void arenaFree(Arena *arena) {
+  ArenaBlock *block = arena->head;
+  ArenaBlock *next;
+  while (block != NULL) {
+    next = block->next;
+    free(block);
+    block = next;
+  }
+  arenaInit(arena, arena->blockSize);
+}
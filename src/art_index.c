@@ -0,0 +1,186 @@
+// Implements an index of cover art files available in ART directories of all devices
+#include "art_index.h"
+#include "arena.h"
+#include "devices.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fileXio_rpc.h>
+#include <io_common.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Index entry
+typedef struct {
+  char *titleID;                    // Uppercase title ID. NULL marks an empty slot
+  uint16_t devices;                 // Bitmask of devices that have cover art for the title
+  uint32_t sizes[MAX_MASS_DEVICES]; // Cover art file size on each device
+} ArtIndexEntry;
+
+// Open-addressing hash set of title IDs that have cover art
+typedef struct {
+  int isLoaded;           // Set once ART directories have been read
+  int total;              // Number of title IDs in the index
+  int size;               // Number of slots, always a power of two
+  ArtIndexEntry *entries; // Slot array
+  Arena arena;            // Arena used to allocate title IDs
+} ArtIndex;
+
+// Arena block size
+#define ART_INDEX_ARENA_BLOCK_SIZE 4096
+
+static ArtIndex artIndex;
+
+static int loadCoverArtIndex();
+static int indexArtDirectory(int device);
+static int addCoverArt(char *titleID, int device, uint32_t size);
+static ArtIndexEntry *findEntry(ArtIndexEntry *entries, int size, const char *titleID);
+static uint32_t hashTitleID(const char *titleID);
+
+// Returns the number of the device that has cover art for titleID, preferring preferredDevice.
+// If size is not NULL, it's set to the size of the cover art file on the returned device.
+// ART directories of all devices are read once on the first call.
+// Returns -1 if cover art for titleID doesn't exist
+int findCoverArtDevice(const char *titleID, int preferredDevice, uint32_t *size) {
+  if (!artIndex.isLoaded && loadCoverArtIndex())
+    return -1;
+  if (artIndex.total == 0)
+    return -1;
+
+  // Title IDs are stored in uppercase
+  char key[256];
+  int i;
+  for (i = 0; (titleID[i] != '\0') && (i < sizeof(key) - 1); i++)
+    key[i] = toupper((unsigned char)titleID[i]);
+  key[i] = '\0';
+
+  ArtIndexEntry *entry = findEntry(artIndex.entries, artIndex.size, key);
+  if (entry->titleID == NULL)
+    return -1;
+
+  int device = -1;
+  if ((preferredDevice >= 0) && (preferredDevice < MAX_MASS_DEVICES) && (entry->devices & (1 << preferredDevice))) {
+    device = preferredDevice;
+  } else {
+    // Use the first device that has cover art
+    for (i = 0; i < MAX_MASS_DEVICES; i++) {
+      if (entry->devices & (1 << i)) {
+        device = i;
+        break;
+      }
+    }
+  }
+
+  if ((device >= 0) && (size != NULL))
+    *size = entry->sizes[device];
+  return device;
+}
+
+// Frees memory used by the cover art index
+void freeCoverArtIndex() {
+  arenaFree(&artIndex.arena);
+  free(artIndex.entries);
+  memset(&artIndex, 0, sizeof(ArtIndex));
+}
+
+// Reads ART directories of all devices into the index
+static int loadCoverArtIndex() {
+  freeCoverArtIndex();
+  arenaInit(&artIndex.arena, ART_INDEX_ARENA_BLOCK_SIZE);
+  artIndex.isLoaded = 1;
+
+  for (int i = 0; i < MAX_MASS_DEVICES; i++) {
+    if (deviceModeMap[i].mode == MODE_ALL)
+      break;
+
+    if (indexArtDirectory(i) == -ENOMEM) {
+      printf("ERROR: Can't allocate enough memory for cover art index\n");
+      return -ENOMEM;
+    }
+  }
+  printf("Found cover art for %d titles\n", artIndex.total);
+  return 0;
+}
+
+// Adds all cover art files located in the ART directory of the device to the index
+static int indexArtDirectory(int device) {
+  char path[sizeof(MASS_PLACEHOLDER) + sizeof(ART_DIRECTORY)];
+  strcpy(path, MASS_PLACEHOLDER);
+  path[4] = device + '0';
+  strcat(path, ART_DIRECTORY);
+
+  int fd = fileXioDopen(path);
+  if (fd < 0)
+    return -ENOENT;
+
+  int res = 0;
+  int suffixLength = strlen(COVER_ART_SUFFIX);
+  iox_dirent_t dirent;
+  while (fileXioDread(fd, &dirent) > 0) {
+    if (FIO_S_ISDIR(dirent.stat.mode))
+      continue;
+
+    // Make sure the file name ends with the cover art suffix
+    int length = strlen(dirent.name) - suffixLength;
+    if ((length <= 0) || strcasecmp(&dirent.name[length], COVER_ART_SUFFIX))
+      continue;
+
+    dirent.name[length] = '\0';
+    for (char *c = dirent.name; *c != '\0'; c++)
+      *c = toupper((unsigned char)*c);
+
+    if ((res = addCoverArt(dirent.name, device, dirent.stat.size)))
+      break;
+  }
+  fileXioDclose(fd);
+  return res;
+}
+
+// Adds titleID to the index, growing the slot array to keep it at most half full
+static int addCoverArt(char *titleID, int device, uint32_t size) {
+  if ((artIndex.total + 1) * 2 > artIndex.size) {
+    int size = (artIndex.size) ? artIndex.size * 2 : 256;
+    ArtIndexEntry *entries = calloc(size, sizeof(ArtIndexEntry));
+    if (entries == NULL)
+      return -ENOMEM;
+
+    // Move existing entries into the new slot array
+    for (int i = 0; i < artIndex.size; i++) {
+      if (artIndex.entries[i].titleID != NULL)
+        *findEntry(entries, size, artIndex.entries[i].titleID) = artIndex.entries[i];
+    }
+    free(artIndex.entries);
+    artIndex.entries = entries;
+    artIndex.size = size;
+  }
+
+  ArtIndexEntry *entry = findEntry(artIndex.entries, artIndex.size, titleID);
+  if (entry->titleID == NULL) {
+    if ((entry->titleID = arenaStrdup(&artIndex.arena, titleID)) == NULL)
+      return -ENOMEM;
+    artIndex.total++;
+  }
+  entry->devices |= 1 << device;
+  entry->sizes[device] = size;
+  return 0;
+}
+
+// Returns the slot that contains titleID or the empty slot where it should be inserted
+static ArtIndexEntry *findEntry(ArtIndexEntry *entries, int size, const char *titleID) {
+  int mask = size - 1;
+  uint32_t slot = hashTitleID(titleID) & mask;
+  while ((entries[slot].titleID != NULL) && strcmp(entries[slot].titleID, titleID))
+    slot = (slot + 1) & mask;
+  return &entries[slot];
+}
+
+// Calculates FNV-1a hash of the title ID
+static uint32_t hashTitleID(const char *titleID) {
+  uint32_t hash = 2166136261u;
+  for (; *titleID != '\0'; titleID++) {
+    hash ^= (uint8_t)*titleID;
+    hash *= 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,536 @@
+// Implements LRU cache of decoded cover art that is filled by a background thread
+#include "cover_cache.h"
+#include "art_index.h"
+#include "devices.h"
+#include "gui_graphics.h"
+#include "options.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <kernel.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Maximum number of requested covers
+#define COVER_MAX_REQUESTS (1 + COVER_PREFETCH_RADIUS * 2 + 2)
+// Loader thread stack size
+#define COVER_THREAD_STACK_SIZE 0x10000
+
+#define COVER_FILE_MAGIC "NCOV"
+#define COVER_FILE_VERSION 2
+// Maximum converted cover dimensions
+#define COVER_FILE_MAX_DIMENSION 1024
+// Rounds x up to the DMA alignment
+#define ALIGN_128(x) (((x) + 127) & ~127)
+
+// Directory for converted covers, relative to the config directory
+const char convertedCoverDirectory[] = "/covers";
+#define MAX_CONVERTED_COVER_PATH_LEN                                                                                                       \
+  (MASS_PLACEHOLDER_LEN + BASE_CONFIG_PATH_LEN + (sizeof(convertedCoverDirectory) / sizeof(char)) + 12 + 4)
+
+// Converted cover file trailer.
+// All fields are fixed-width and little-endian.
+// The file starts with pixel data and the optional CLUT, each aligned to 128 bytes, so the whole file
+// can be read into a single buffer and uploaded to VRAM as is. The trailer is stored at the end of the file.
+typedef struct {
+  char magic[4];       // Must be always equal to COVER_FILE_MAGIC
+  uint8_t version;     // File version
+  uint8_t psm;         // Texture pixel storage mode: GS_PSM_CT16, GS_PSM_T8 or GS_PSM_T4
+  uint8_t clutPSM;     // CLUT pixel storage mode
+  uint8_t reserved;    //
+  uint16_t width;      // Texture width
+  uint16_t height;     // Texture height
+  uint32_t clutOffset; // CLUT offset. 0 if the texture doesn't use CLUT
+  uint32_t sourceSize; // Size of the source PNG, used to detect replaced covers
+} CoverFileTrailer;
+
+typedef enum {
+  COVER_EMPTY,   // Entry is not used
+  COVER_LOADING, // Cover is being decoded
+  COVER_READY,   // Cover is decoded and can be used
+  COVER_MISSING, // Title doesn't have a cover or it couldn't be decoded
+} CoverState;
+
+// Decoded cover
+typedef struct {
+  char titleID[12];  // Title ID
+  CoverState state;  // Entry state
+  GSTEXTURE texture; // Decoded texture. Texture memory and CLUT are a single buffer owned by the entry
+  uint32_t lastUsed; // Value of the usage counter when the entry was last requested
+} CoverEntry;
+
+// Requested cover
+typedef struct {
+  char titleID[12]; // Title ID
+  int device;       // Title device, used to prefer covers located on the same device
+} CoverRequest;
+
+// Cover cache state. Entries and requests are protected by lockSema
+typedef struct {
+  CoverEntry entries[COVER_CACHE_SIZE];
+  CoverRequest requests[COVER_MAX_REQUESTS]; // Requested covers in priority order
+  int requestCount;                          // Number of requested covers
+  int pinnedIdx;                             // Index of the entry that is currently displayed. Never evicted
+  uint32_t usageCounter;                     // Incremented on every request
+
+  GSGLOBAL *gsGlobal;
+  volatile int isStopRequested; // Set to stop the loader thread
+  int threadID;                 // Loader thread ID. Negative if the thread is not running
+  void *stack;                  // Loader thread stack
+  int lockSema;                 // Semaphore used as a mutex
+  int wakeSema;                 // Semaphore signalled when requests change
+  int doneSema;                 // Semaphore signalled when the loader thread finishes
+} CoverCache;
+
+extern void *_gp;
+
+static CoverCache coverCache = {.threadID = -1, .lockSema = -1, .wakeSema = -1, .doneSema = -1};
+
+static void coverLoaderThread(void *arg);
+static int loadNextCover();
+static int findCoverEntry(const char *titleID);
+static int decodeCover(const char *titleID, int device, GSTEXTURE *texture);
+static int getCoverFileSize(int width, int height, int psm, int clutPSM, uint32_t *clutOffset);
+static int loadConvertedCover(const char *path, uint32_t sourceSize, GSTEXTURE *texture);
+static int convertCover(GSTEXTURE *texture, uint32_t sourceSize);
+static void storeConvertedCover(int device, const char *titleID, GSTEXTURE *texture, int size);
+static void freeCoverEntry(CoverEntry *entry);
+
+// Starts the cover loader thread.
+// The thread runs with lower priority than the calling thread, so covers are only decoded while the UI is waiting for vsync
+int initCoverCache(GSGLOBAL *gsGlobal) {
+  memset(&coverCache, 0, sizeof(CoverCache));
+  coverCache.gsGlobal = gsGlobal;
+  coverCache.pinnedIdx = -1;
+  coverCache.threadID = -1;
+
+  ee_thread_status_t threadStatus;
+  int priority = 0;
+  if (ReferThreadStatus(GetThreadId(), &threadStatus) >= 0)
+    priority = threadStatus.current_priority + 1;
+
+  ee_sema_t sema = {.init_count = 1, .max_count = 1, .option = 0};
+  coverCache.lockSema = CreateSema(&sema);
+  sema.init_count = 0;
+  coverCache.wakeSema = CreateSema(&sema);
+  coverCache.doneSema = CreateSema(&sema);
+  coverCache.stack = memalign(16, COVER_THREAD_STACK_SIZE);
+  if ((coverCache.lockSema < 0) || (coverCache.wakeSema < 0) || (coverCache.doneSema < 0) || (coverCache.stack == NULL)) {
+    printf("ERROR: Failed to initialize cover cache\n");
+    closeCoverCache();
+    return -ENOMEM;
+  }
+
+  ee_thread_t thread = {
+      .func = coverLoaderThread,
+      .stack = coverCache.stack,
+      .stack_size = COVER_THREAD_STACK_SIZE,
+      .gp_reg = &_gp,
+      .initial_priority = priority,
+      .attr = 0,
+      .option = 0,
+  };
+  int threadID = CreateThread(&thread);
+  if (threadID < 0) {
+    printf("ERROR: Failed to create cover loader thread: %d\n", threadID);
+    closeCoverCache();
+    return threadID;
+  }
+
+  coverCache.threadID = threadID;
+  StartThread(threadID, NULL);
+  return 0;
+}
+
+// Stops the cover loader thread and frees all decoded covers
+void closeCoverCache() {
+  if (coverCache.threadID >= 0) {
+    coverCache.isStopRequested = 1;
+    SignalSema(coverCache.wakeSema);
+    WaitSema(coverCache.doneSema);
+    TerminateThread(coverCache.threadID);
+    DeleteThread(coverCache.threadID);
+    coverCache.threadID = -1;
+  }
+  if (coverCache.lockSema >= 0)
+    DeleteSema(coverCache.lockSema);
+  if (coverCache.wakeSema >= 0)
+    DeleteSema(coverCache.wakeSema);
+  if (coverCache.doneSema >= 0)
+    DeleteSema(coverCache.doneSema);
+  coverCache.lockSema = coverCache.wakeSema = coverCache.doneSema = -1;
+
+  for (int i = 0; i < COVER_CACHE_SIZE; i++)
+    freeCoverEntry(&coverCache.entries[i]);
+  free(coverCache.stack);
+  coverCache.stack = NULL;
+}
+
+// Adds a request for the target cover, skipping targets without a valid title ID
+static void addCoverRequest(Target *target) {
+  if ((target == NULL) || (target->id == NULL) || (target->id[0] == '\0') || (coverCache.requestCount == COVER_MAX_REQUESTS))
+    return;
+
+  CoverRequest *request = &coverCache.requests[coverCache.requestCount++];
+  strncpy(request->titleID, target->id, sizeof(request->titleID) - 1);
+  request->titleID[sizeof(request->titleID) - 1] = '\0';
+  request->device = target->fullPath[4] - '0';
+
+  // Mark cached entries as recently used
+  int idx = findCoverEntry(request->titleID);
+  if (idx >= 0)
+    coverCache.entries[idx].lastUsed = coverCache.usageCounter;
+}
+
+// Requests covers for the selected title, its neighbours and titles one page away.
+// Covers are decoded in the background, starting from the selected title
+void setCoverArtFocus(TargetList *titles, int selectedIdx, int pageSize) {
+  if (coverCache.threadID < 0)
+    return;
+
+  WaitSema(coverCache.lockSema);
+  coverCache.usageCounter++;
+  coverCache.requestCount = 0;
+  addCoverRequest(getTargetByIdx(titles, selectedIdx));
+  for (int offset = 1; offset <= COVER_PREFETCH_RADIUS; offset++) {
+    addCoverRequest(getTargetByIdx(titles, selectedIdx + offset));
+    addCoverRequest(getTargetByIdx(titles, selectedIdx - offset));
+  }
+  if (pageSize > COVER_PREFETCH_RADIUS) {
+    addCoverRequest(getTargetByIdx(titles, selectedIdx + pageSize));
+    addCoverRequest(getTargetByIdx(titles, selectedIdx - pageSize));
+  }
+  SignalSema(coverCache.lockSema);
+  SignalSema(coverCache.wakeSema);
+}
+
+// Fills texture with the decoded cover for titleID without blocking.
+// The cover stays in memory until another cover is returned.
+// Returns 0 if the cover is ready, -EAGAIN if it's still being loaded or -ENOENT if the title has no cover
+int getCoverArt(const char *titleID, GSTEXTURE *texture) {
+  if ((titleID == NULL) || (titleID[0] == '\0') || (coverCache.threadID < 0))
+    return -ENOENT;
+
+  int res = -EAGAIN;
+  WaitSema(coverCache.lockSema);
+  int idx = findCoverEntry(titleID);
+  if (idx >= 0) {
+    CoverEntry *entry = &coverCache.entries[idx];
+    if (entry->state == COVER_READY) {
+      // Keep the entry in memory while the texture is in use
+      coverCache.pinnedIdx = idx;
+      *texture = entry->texture;
+      res = 0;
+    } else if (entry->state == COVER_MISSING) {
+      res = -ENOENT;
+    }
+  }
+  SignalSema(coverCache.lockSema);
+  return res;
+}
+
+// Decodes requested covers until all of them are cached
+static void coverLoaderThread(void *arg) {
+  while (!coverCache.isStopRequested) {
+    WaitSema(coverCache.wakeSema);
+    while (!coverCache.isStopRequested && loadNextCover())
+      ;
+  }
+  SignalSema(coverCache.doneSema);
+  ExitThread();
+}
+
+// Decodes the first requested cover that is not cached yet.
+// Returns 0 if there's nothing left to decode
+static int loadNextCover() {
+  WaitSema(coverCache.lockSema);
+  CoverRequest request;
+  int i;
+  for (i = 0; i < coverCache.requestCount; i++) {
+    if (findCoverEntry(coverCache.requests[i].titleID) < 0)
+      break;
+  }
+  if (i == coverCache.requestCount) {
+    SignalSema(coverCache.lockSema);
+    return 0;
+  }
+  request = coverCache.requests[i];
+
+  // Evict the least recently used entry that is not displayed or requested
+  int victimIdx = -1;
+  for (i = 0; i < COVER_CACHE_SIZE; i++) {
+    CoverEntry *entry = &coverCache.entries[i];
+    if (entry->state == COVER_EMPTY) {
+      victimIdx = i;
+      break;
+    }
+    if ((i == coverCache.pinnedIdx) || (entry->lastUsed == coverCache.usageCounter))
+      continue;
+    if ((victimIdx < 0) || (entry->lastUsed < coverCache.entries[victimIdx].lastUsed))
+      victimIdx = i;
+  }
+  if (victimIdx < 0) {
+    SignalSema(coverCache.lockSema);
+    return 0;
+  }
+
+  CoverEntry *entry = &coverCache.entries[victimIdx];
+  freeCoverEntry(entry);
+  strcpy(entry->titleID, request.titleID);
+  entry->state = COVER_LOADING;
+  entry->lastUsed = coverCache.usageCounter;
+  SignalSema(coverCache.lockSema);
+
+  // Decode the cover without holding the lock
+  GSTEXTURE texture;
+  int res = decodeCover(request.titleID, request.device, &texture);
+
+  WaitSema(coverCache.lockSema);
+  if (res) {
+    entry->state = COVER_MISSING;
+  } else {
+    entry->texture = texture;
+    entry->state = COVER_READY;
+  }
+  SignalSema(coverCache.lockSema);
+  return 1;
+}
+
+// Returns index of the cache entry for titleID or -1 if the title is not cached
+static int findCoverEntry(const char *titleID) {
+  for (int i = 0; i < COVER_CACHE_SIZE; i++) {
+    if ((coverCache.entries[i].state != COVER_EMPTY) && !strcmp(coverCache.entries[i].titleID, titleID))
+      return i;
+  }
+  return -1;
+}
+
+// Loads cover art for titleID into texture memory.
+// Covers are loaded from the converted cover file if it exists and matches the source PNG,
+// otherwise the PNG is decoded and converted into a GS-ready texture that is stored on the cover device
+static int decodeCover(const char *titleID, int device, GSTEXTURE *texture) {
+  // Titles without cover art are skipped without any I/O
+  uint32_t sourceSize = 0;
+  if ((device = findCoverArtDevice(titleID, device, &sourceSize)) < 0)
+    return -ENOENT;
+
+  char path[MAX_CONVERTED_COVER_PATH_LEN];
+  buildConfigFilePath(path, MASS_PLACEHOLDER, convertedCoverDirectory);
+  path[4] = device + '0';
+  snprintf(&path[strlen(path)], sizeof(path) - strlen(path), "/%s.bin", titleID);
+  if (!loadConvertedCover(path, sourceSize, texture))
+    return 0;
+
+  char pngPath[sizeof(MASS_PLACEHOLDER) + sizeof(ART_DIRECTORY) + 12 + sizeof(COVER_ART_SUFFIX)];
+  strcpy(pngPath, MASS_PLACEHOLDER);
+  pngPath[4] = device + '0';
+  snprintf(&pngPath[sizeof(MASS_PLACEHOLDER) - 1], sizeof(pngPath) - sizeof(MASS_PLACEHOLDER) + 1, "%s/%s%s", ART_DIRECTORY, titleID,
+           COVER_ART_SUFFIX);
+
+  // Read the whole PNG with a single read
+  int fd = open(pngPath, O_RDONLY);
+  if (fd < 0)
+    return -ENOENT;
+  int pngSize = lseek(fd, 0, SEEK_END);
+  char *png = NULL;
+  if ((pngSize <= 0) || (lseek(fd, 0, SEEK_SET) != 0) || ((png = malloc(pngSize)) == NULL) || (read(fd, png, pngSize) != pngSize)) {
+    close(fd);
+    free(png);
+    return -EIO;
+  }
+  close(fd);
+
+  // Decode rows directly into texture memory.
+  // Delayed textures are only decoded into EE RAM
+  memset(texture, 0, sizeof(GSTEXTURE));
+  texture->Delayed = 1;
+  int res = gsKit_texture_png_mem(coverCache.gsGlobal, texture, png, pngSize);
+  free(png);
+  if (res)
+    return -EIO;
+
+  int size = convertCover(texture, sourceSize);
+  if (size < 0) {
+    free(texture->Mem);
+    free(texture->Clut);
+    texture->Mem = NULL;
+    return size;
+  }
+  storeConvertedCover(device, titleID, texture, size);
+  return 0;
+}
+
+// Returns the size of the converted cover file for the texture format or -EINVAL if the format is not supported.
+// Sets clutOffset to the CLUT offset or 0 if the format doesn't use CLUT
+static int getCoverFileSize(int width, int height, int psm, int clutPSM, uint32_t *clutOffset) {
+  if ((width <= 0) || (height <= 0) || (width > COVER_FILE_MAX_DIMENSION) || (height > COVER_FILE_MAX_DIMENSION))
+    return -EINVAL;
+
+  int size = ALIGN_128(gsKit_texture_size_ee(width, height, psm));
+  *clutOffset = 0;
+  switch (psm) {
+  case GS_PSM_CT16:
+    break;
+  case GS_PSM_T8:
+    *clutOffset = size;
+    size += ALIGN_128(gsKit_texture_size_ee(16, 16, clutPSM));
+    break;
+  case GS_PSM_T4:
+    *clutOffset = size;
+    size += ALIGN_128(gsKit_texture_size_ee(8, 2, clutPSM));
+    break;
+  default:
+    return -EINVAL;
+  }
+  return size + sizeof(CoverFileTrailer);
+}
+
+// Loads converted cover from path into texture with a single read.
+// Returns -ENOENT if the file doesn't exist or doesn't match the source PNG
+static int loadConvertedCover(const char *path, uint32_t sourceSize, GSTEXTURE *texture) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -ENOENT;
+
+  // Largest supported texture is CT16
+  uint32_t clutOffset;
+  int maxSize = getCoverFileSize(COVER_FILE_MAX_DIMENSION, COVER_FILE_MAX_DIMENSION, GS_PSM_CT16, 0, &clutOffset);
+  int size = lseek(fd, 0, SEEK_END);
+  char *buf = NULL;
+  if ((size < (int)sizeof(CoverFileTrailer)) || (size > maxSize) || (lseek(fd, 0, SEEK_SET) != 0) || ((buf = memalign(128, size)) == NULL) ||
+      (read(fd, buf, size) != size)) {
+    close(fd);
+    free(buf);
+    return -ENOENT;
+  }
+  close(fd);
+
+  CoverFileTrailer *trailer = (CoverFileTrailer *)&buf[size - sizeof(CoverFileTrailer)];
+  if (memcmp(trailer->magic, COVER_FILE_MAGIC, sizeof(trailer->magic)) || (trailer->version != COVER_FILE_VERSION) ||
+      (trailer->sourceSize != sourceSize) ||
+      (getCoverFileSize(trailer->width, trailer->height, trailer->psm, trailer->clutPSM, &clutOffset) != size) ||
+      (trailer->clutOffset != clutOffset)) {
+    free(buf);
+    return -ENOENT;
+  }
+
+  memset(texture, 0, sizeof(GSTEXTURE));
+  texture->Width = trailer->width;
+  texture->Height = trailer->height;
+  texture->PSM = trailer->psm;
+  texture->ClutPSM = trailer->clutPSM;
+  texture->Mem = (u32 *)buf;
+  texture->Clut = (clutOffset) ? (u32 *)&buf[clutOffset] : NULL;
+  texture->Delayed = 1;
+  gsKit_setup_tbw(texture);
+  return 0;
+}
+
+// Converts the decoded PNG texture into the converted cover file layout, replacing texture memory.
+// 24-bit and 32-bit textures are converted to CT16 with 1-bit alpha, paletted textures are kept as is.
+// 32-bit textures must use the inverted GS alpha produced by gsKit_texture_png_mem.
+// Returns the size of the file contents
+static int convertCover(GSTEXTURE *texture, uint32_t sourceSize) {
+  int psm = texture->PSM;
+  int bytesPerPixel = 0;
+  if (psm == GS_PSM_CT32) {
+    bytesPerPixel = 4;
+    psm = GS_PSM_CT16;
+  } else if (psm == GS_PSM_CT24) {
+    bytesPerPixel = 3;
+    psm = GS_PSM_CT16;
+  }
+
+  uint32_t clutOffset;
+  int size = getCoverFileSize(texture->Width, texture->Height, psm, texture->ClutPSM, &clutOffset);
+  if (size < 0)
+    return size;
+
+  char *buf = memalign(128, size);
+  if (buf == NULL)
+    return -ENOMEM;
+  memset(buf, 0, size);
+
+  if (bytesPerPixel) {
+    uint8_t *src = (uint8_t *)texture->Mem;
+    uint16_t *dst = (uint16_t *)buf;
+    int pixelCount = texture->Width * texture->Height;
+    for (int i = 0; i < pixelCount; i++, src += bytesPerPixel) {
+      uint16_t pixel = (src[0] >> 3) | ((src[1] >> 3) << 5) | ((src[2] >> 3) << 10);
+      // Keep pixels that are at least half opaque (decoded alpha 0 is fully opaque and 0x80 is fully transparent)
+      if ((bytesPerPixel == 3) || (src[3] <= 0x40))
+        pixel |= 0x8000;
+      dst[i] = pixel;
+    }
+  } else {
+    memcpy(buf, texture->Mem, gsKit_texture_size_ee(texture->Width, texture->Height, psm));
+    // Copy only the CLUT itself, the source buffer is not padded and padding is already zeroed
+    if (psm == GS_PSM_T8)
+      memcpy(&buf[clutOffset], texture->Clut, gsKit_texture_size_ee(16, 16, texture->ClutPSM));
+    else if (psm == GS_PSM_T4)
+      memcpy(&buf[clutOffset], texture->Clut, gsKit_texture_size_ee(8, 2, texture->ClutPSM));
+  }
+
+  CoverFileTrailer *trailer = (CoverFileTrailer *)&buf[size - sizeof(CoverFileTrailer)];
+  memcpy(trailer->magic, COVER_FILE_MAGIC, sizeof(trailer->magic));
+  trailer->version = COVER_FILE_VERSION;
+  trailer->psm = psm;
+  trailer->clutPSM = texture->ClutPSM;
+  trailer->width = texture->Width;
+  trailer->height = texture->Height;
+  trailer->clutOffset = clutOffset;
+  trailer->sourceSize = sourceSize;
+
+  free(texture->Mem);
+  free(texture->Clut);
+  texture->PSM = psm;
+  texture->Mem = (u32 *)buf;
+  texture->Clut = (clutOffset) ? (u32 *)&buf[clutOffset] : NULL;
+  gsKit_setup_tbw(texture);
+  return size;
+}
+
+// Writes size bytes of converted cover texture memory to the config directory of the device.
+// Failures are not fatal since the cover is converted again the next time it's loaded
+static void storeConvertedCover(int device, const char *titleID, GSTEXTURE *texture, int size) {
+  char path[MAX_CONVERTED_COVER_PATH_LEN];
+  buildConfigFilePath(path, MASS_PLACEHOLDER, NULL);
+  path[4] = device + '0';
+
+  // Make sure config and cover directories exist
+  struct stat st;
+  if ((stat(path, &st) == -1) && mkdir(path, 0777)) {
+    printf("ERROR: Failed to create config directory\n");
+    return;
+  }
+  strcat(path, convertedCoverDirectory);
+  if ((stat(path, &st) == -1) && mkdir(path, 0777)) {
+    printf("ERROR: Failed to create converted cover directory\n");
+    return;
+  }
+  snprintf(&path[strlen(path)], sizeof(path) - strlen(path), "/%s.bin", titleID);
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    printf("ERROR: Failed to open %s for writing\n", path);
+    return;
+  }
+  if (write(fd, texture->Mem, size) != size) {
+    printf("ERROR: Failed to write converted cover: %d\n", errno);
+    close(fd);
+    remove(path);
+    return;
+  }
+  close(fd);
+}
+
+// Frees texture memory and marks the entry as empty.
+// CLUT is always stored in the texture memory buffer
+static void freeCoverEntry(CoverEntry *entry) {
+  free(entry->texture.Mem);
+  memset(entry, 0, sizeof(CoverEntry));
+}
@@ -1,10 +1,14 @@
 #include "gui.h"
+#include "art_index.h"
 #include "common.h"
+#include "cover_cache.h"
 #include "gui_graphics.h"
 #include "launcher.h"
 #include "options.h"
 #include "pad.h"
+#include "vsync.h"
 #include <dmaKit.h>
+#include <errno.h>
 #include <gsKit.h>
 #include <gsToolkit.h>
 #include <libpad.h>
@@ -14,13 +18,15 @@
 #include <stdio.h>
 
 #define DIV_ROUND(n, d) (n + (d - 1)) / d
+// GS frame buffers must be aligned to the VRAM page size
+#define GS_VRAM_PAGE_SIZE 8192
 
 // Assuming 140x200 cover art
 #define COVER_ART_RES_W 140
 #define COVER_ART_RES_H 200
 
 int uiLoop(TargetList *titles);
-int uiTitleOptionsLoop(Target *title);
+int uiTitleOptionsLoop(TargetList *titles, Target *target);
 void drawTitleList(TargetList *titles, int selectedTitleIdx, int maxTitlesPerPage, GSTEXTURE *selectedTitleCover);
 void drawArgumentList(ArgumentList *arguments, int baseX, uint8_t compatModes, int selectedArgIdx);
 void uiLaunchTitle(Target *target, ArgumentList *arguments);
@@ -29,10 +35,7 @@ void drawGameID(const char *game_id);
 GSGLOBAL *gsGlobal;
 static GSTEXTURE *coverTexture;
 static char lineBuffer[255];
-
-// Path relative to storage device mountpoint.
-// Used to load cover art
-static const char artPath[] = "/ART";
+static int vsyncSema = -1; // Used to sleep while the screen doesn't need to be redrawn
 
 // Predefined colors
 // static const uint64_t ColorWhite = GS_SETREG_RGBA(0xFF, 0xFF, 0xFF, 0x80);
@@ -55,6 +58,33 @@ static const int keepoutArea = 20;
 static const int headerHeight = 20 + keepoutArea;
 static const int footerHeight = 40 + keepoutArea;
 
+// Static UI elements recorded into the persistent queue
+typedef enum {
+  CHROME_INVALID,       // Persistent queue is empty
+  CHROME_NONE,          // Background only
+  CHROME_TITLE_LIST,    // Title list header, footer and cover art frame
+  CHROME_TITLE_OPTIONS, // Title options header and footer
+} ChromeType;
+
+static ChromeType recordedChrome = CHROME_INVALID;
+
+// Title list page cached in VRAM.
+// Titles are drawn into the texture once per page, moving the selection redraws only two lines
+typedef struct {
+  GSTEXTURE texture; // Render target. Vram is set to GSKIT_ALLOC_ERROR if the page can't be cached
+  int width;         // Width of the visible part of the texture
+  int height;        // Height of the visible part of the texture
+  int firstIdx;      // Index of the first title drawn into the texture. Negative if the texture must be redrawn
+  int selectedIdx;   // Index of the title highlighted in the texture
+} TitleListPage;
+
+static TitleListPage titleListPage;
+
+static void setStaticChrome(ChromeType chrome);
+static void initTitleListPage();
+void drawTitleListFooter(int baseX);
+void drawTitleOptionsFooter(int baseX);
+
 void init480p(GSGLOBAL *gsGlobal) {
   gsGlobal->Mode = GS_MODE_DTV_480P;
   gsGlobal->Interlace = GS_NONINTERLACED;
@@ -89,6 +119,14 @@ int uiInit() {
   // Init screen
   gsKit_vram_clear(gsGlobal);
   gsKit_init_screen(gsGlobal);
+
+  // Allocate the title list page before the texture manager takes over the rest of VRAM
+  coverArtX2 = (gsGlobal->Width - keepoutArea - 10);
+  coverArtY2 = (gsGlobal->Height / 2) + (COVER_ART_RES_H / 2);
+  coverArtX1 = coverArtX2 - COVER_ART_RES_W;
+  coverArtY1 = coverArtY2 - COVER_ART_RES_H;
+  initTitleListPage();
+
   gsKit_TexManager_init(gsGlobal);
   gsKit_set_primalpha(gsGlobal, GS_SETREG_ALPHA(0, 1, 0, 1, 0), 0);
   gsKit_set_test(gsGlobal, GS_ATEST_ON);
@@ -103,50 +141,132 @@ int uiInit() {
 
   // Init cover texture
   coverTexture = calloc(sizeof(GSTEXTURE), 1);
-  coverArtX2 = (gsGlobal->Width - keepoutArea - 10);
-  coverArtY2 = (gsGlobal->Height / 2) + (COVER_ART_RES_H / 2);
-  coverArtX1 = coverArtX2 - COVER_ART_RES_W;
-  coverArtY1 = coverArtY2 - COVER_ART_RES_H;
   coverTexture->Delayed = 1;
+  initCoverCache(gsGlobal);
 
-  // Init gamepad inputs
-  initPad();
-  return 0;
+  // Init vsync handler and gamepad inputs
+  if ((res = initVSync()))
+    return res;
+  if ((vsyncSema = createVSyncSema()) < 0) {
+    printf("ERROR: Failed to create vsync semaphore: %d\n", vsyncSema);
+    return vsyncSema;
+  }
+  return initPad();
 }
 
-// Invalidates currently loaded texture and loads a new one
-int loadCoverArt(char *titlePath, char *titleID) {
-  // Reuse line buffer for building texture path
-  // Get device mountpoint into the buffer
-  int pathSize = 5;
-  if (titlePath[4] == ':') {
-    strncpy(lineBuffer, titlePath, 5);
-  } else { // Handle numbered devices
-    strncpy(lineBuffer, titlePath, 6);
-    pathSize = 6;
+// Allocates VRAM for the title list page.
+// Falls back to drawing titles directly to the screen if there's not enough VRAM
+static void initTitleListPage() {
+  TitleListPage *page = &titleListPage;
+  memset(page, 0, sizeof(TitleListPage));
+  page->firstIdx = -1;
+
+  // Titles end at the cover art frame and start half a line below the header
+  int maxTitlesPerPage = (gsGlobal->Height - (headerHeight + footerHeight)) / getFontLineHeight();
+  page->width = coverArtX1 - 2 - (keepoutArea + 10);
+  page->height = maxTitlesPerPage * getFontLineHeight() + getFontLineHeight() / 2;
+
+  // Frame buffer width must be a multiple of 64 and its address must be aligned to the VRAM page
+  GSTEXTURE *texture = &page->texture;
+  texture->Width = (page->width + 63) & ~63;
+  texture->Height = page->height;
+  texture->PSM = GS_PSM_CT32;
+  texture->Filter = GS_FILTER_NEAREST;
+  gsKit_setup_tbw(texture);
+
+  u32 padding = (GS_VRAM_PAGE_SIZE - (gsGlobal->CurrentPointer % GS_VRAM_PAGE_SIZE)) % GS_VRAM_PAGE_SIZE;
+  u32 size = (gsKit_texture_size(texture->Width, texture->Height, texture->PSM) + GS_VRAM_PAGE_SIZE - 1) & ~(GS_VRAM_PAGE_SIZE - 1);
+  texture->Vram = gsKit_vram_alloc(gsGlobal, padding + size, GSKIT_ALLOC_SYSBUFFER);
+  if (texture->Vram == GSKIT_ALLOC_ERROR) {
+    printf("WARN: Not enough VRAM to cache the title list\n");
+    return;
   }
+  texture->Vram += padding;
+}
+
+// Redirects drawing to the texture.
+// Z buffer setup is left to gsKit since the texture is never larger than the screen
+static void beginRenderToTexture(GSTEXTURE *texture) {
+  u64 *p_data = gsKit_heap_alloc(gsGlobal, 2, 32, GIF_AD);
+  *p_data++ = GIF_TAG_AD(1);
+  *p_data++ = GIF_AD;
+  *p_data++ = GS_SETREG_FRAME_1(texture->Vram / GS_VRAM_PAGE_SIZE, texture->TBW, texture->PSM, 0);
+  *p_data++ = GS_FRAME_1;
+  gsKit_set_scissor(gsGlobal, GS_SETREG_SCISSOR_1(0, texture->Width - 1, 0, texture->Height - 1));
+}
+
+// Redirects drawing back to the screen and flushes the texture cache so the rendered texture can be used.
+// The frame buffer and scissor are restored by gsKit, which knows the current buffer in every video mode
+static void endRenderToTexture() {
+  gsKit_setactive(gsGlobal);
+  gsKit_set_scissor(gsGlobal, GS_SCISSOR_RESET);
+
+  u64 *p_data = gsKit_heap_alloc(gsGlobal, 2, 32, GIF_AD);
+  *p_data++ = GIF_TAG_AD(1);
+  *p_data++ = GIF_AD;
+  *p_data++ = 0;
+  *p_data++ = GS_TEXFLUSH;
+}
 
-  // Append cover art path to the mountpoint
-  snprintf(lineBuffer + pathSize, 255 - pathSize, "%s/%s_COV.png", artPath, titleID);
-  // Upload new texture
+// Replaces currently loaded texture with the cover for titleID if it has already been decoded.
+// Returns 0 if the cover is ready, -EAGAIN if it's still being loaded or -ENOENT if the title has no cover
+int loadCoverArt(char *titleID) {
+  GSTEXTURE cover;
+  int res = getCoverArt(titleID, &cover);
+  if (res)
+    return res;
+
+  // Upload new texture. Texture memory is owned by the cover cache
   gsKit_TexManager_invalidate(gsGlobal, coverTexture);
-  if (gsKit_texture_png(gsGlobal, coverTexture, lineBuffer)) {
-    return -1;
-  }
+  *coverTexture = cover;
   gsKit_TexManager_bind(gsGlobal, coverTexture);
-  // Free memory after the texture has been uploaded
-  free(coverTexture->Mem);
-  coverTexture->Mem = NULL;
   return 0;
 }
 
 // Closes gamepad driver, frees textures and deinits gsKit
 void closeUI() {
   closePad();
+  closeVSync();
+  vsyncSema = -1;
+  closeCoverCache();
   gsKit_vram_clear(gsGlobal);
   closeFont();
   free(coverTexture);
+  freeCoverArtIndex();
   gsKit_deinit_global(gsGlobal);
+  recordedChrome = CHROME_INVALID;
+}
+
+// Records static UI elements of the screen into the persistent queue unless they are already recorded.
+// The persistent queue is replayed before the oneshot queue on every gsKit_queue_exec() call and also clears the screen,
+// so only dynamic content has to be drawn each frame
+static void setStaticChrome(ChromeType chrome) {
+  if (recordedChrome == chrome)
+    return;
+
+  gsKit_queue_reset(gsGlobal->Per_Queue);
+  gsKit_mode_switch(gsGlobal, GS_PERSISTENT);
+  gsKit_clear(gsGlobal, BGColor);
+
+  int baseX = keepoutArea + 10;
+  switch (chrome) {
+  case CHROME_TITLE_LIST:
+    drawTextWindow(baseX, headerHeight - getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, HeaderTextColor, ALIGN_HCENTER, "Title List");
+    drawTitleListFooter(baseX);
+    // Draw cover art frame
+    gsKit_prim_sprite(gsGlobal, coverArtX1 - 2, coverArtY1 - 2, coverArtX2 + 2, coverArtY2 + 2, 1, FontMainColor);
+    break;
+  case CHROME_TITLE_OPTIONS:
+    drawTextWindow(baseX, headerHeight + 1.5 * getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, FontMainColor, ALIGN_HCENTER,
+                   "Compatibility modes");
+    drawTitleOptionsFooter(baseX);
+    break;
+  default:
+    break;
+  }
+
+  gsKit_mode_switch(gsGlobal, GS_ONESHOT);
+  recordedChrome = chrome;
 }
 
 // Main UI loop. Displays the target list.
@@ -187,80 +307,115 @@ int uiLoop(TargetList *titles) {
   free(lastTitle);
 
   // Load cover art
-  isCoverUninitialized = loadCoverArt(curTarget->fullPath, curTarget->id);
+  setTitleIDFocus(titles, curTarget->idx);
+  setCoverArtFocus(titles, curTarget->idx, maxTitlesPerPage);
+  char *coverTitleID = curTarget->id; // Title ID used to load the current cover art
+  isCoverUninitialized = loadCoverArt(coverTitleID);
 
   // Main UI loop
-  int frameCount = 0;
-  int prevInput = 0;
-  int input = 0;
+  int isDirty = 1; // Set when the screen must be redrawn
   while (1) {
-    gsKit_clear(gsGlobal, BGColor);
-    gsKit_TexManager_nextFrame(gsGlobal);
+    // Switch to the up-to-date list once the snapshot has been validated in the background
+    if (updateTargetList(titles, &selectedTitleIdx)) {
+      titleListPage.firstIdx = -1; // Redraw the title list page
+      curTarget = getTargetByIdx(titles, selectedTitleIdx);
+      setTitleIDFocus(titles, selectedTitleIdx);
+      setCoverArtFocus(titles, selectedTitleIdx, maxTitlesPerPage);
+      coverTitleID = curTarget->id;
+      isCoverUninitialized = loadCoverArt(coverTitleID);
+      isDirty = 1;
+    }
 
     // Reload target if index has changed
     if (curTarget->idx != selectedTitleIdx) {
       curTarget = getTargetByIdx(titles, selectedTitleIdx);
-      isCoverUninitialized = loadCoverArt(curTarget->fullPath, curTarget->id);
+      setTitleIDFocus(titles, selectedTitleIdx);
+      setCoverArtFocus(titles, selectedTitleIdx, maxTitlesPerPage);
+      coverTitleID = curTarget->id;
+      isCoverUninitialized = loadCoverArt(coverTitleID);
+      isDirty = 1;
+    } else if (curTarget->id != coverTitleID) {
+      // Load cover art once title ID has been resolved in the background
+      setCoverArtFocus(titles, selectedTitleIdx, maxTitlesPerPage);
+      coverTitleID = curTarget->id;
+      isCoverUninitialized = loadCoverArt(coverTitleID);
+      isDirty = 1;
+    } else if (isCoverUninitialized == -EAGAIN) {
+      // Show cover art once it has been decoded, drawing the placeholder until then
+      if ((isCoverUninitialized = loadCoverArt(coverTitleID)) != -EAGAIN)
+        isDirty = 1;
     }
 
-    // Draw title list
-    if (!isCoverUninitialized)
-      drawTitleList(titles, selectedTitleIdx, maxTitlesPerPage, coverTexture);
-    else
-      drawTitleList(titles, selectedTitleIdx, maxTitlesPerPage, NULL);
-
-    gsKit_queue_exec(gsGlobal);
-    gsKit_sync_flip(gsGlobal);
-
-    // Process user inputs:
-    if (input == -1)            // If input is -1, block until input changes
-      input = waitForInput(-1); // Used to ignore held inputs after returning from title options
-    else
-      input = pollInput();
-
-    frameCount = (frameCount + 1) % 10;
-    if (frameCount && (input == prevInput)) // Handle input only every 10th frame unless it changes
-      continue;
-
-    frameCount = 0;
-    prevInput = input;
+    if (isDirty) {
+      // Draw title list
+      setStaticChrome(CHROME_TITLE_LIST);
+      gsKit_TexManager_nextFrame(gsGlobal);
+      if (!isCoverUninitialized)
+        drawTitleList(titles, selectedTitleIdx, maxTitlesPerPage, coverTexture);
+      else
+        drawTitleList(titles, selectedTitleIdx, maxTitlesPerPage, NULL);
+
+      gsKit_queue_exec(gsGlobal);
+      gsKit_sync_flip(gsGlobal);
+      isDirty = 0;
+    } else {
+      // Nothing has changed, leave the CPU to background threads until the next frame
+      waitForVSync(vsyncSema);
+    }
 
-    if (input & (PAD_CROSS | PAD_CIRCLE)) {
-      // Copy target, free title list and launch
-      Target *target = copyTarget(curTarget);
-      freeTargetList(titles);
-      uiLaunchTitle(target, NULL);
-      // Something went wrong, main loop must exit immediately
-      return -1;
-    } else if (input & PAD_UP) {
-      // Point to the previous title
-      if (selectedTitleIdx > 0)
-        selectedTitleIdx--;
-    } else if (input & PAD_DOWN) {
-      // Advance to the next title
-      if (selectedTitleIdx < titles->total - 1)
-        selectedTitleIdx++;
-    } else if (input & (PAD_RIGHT | PAD_R1)) {
-      // Switch to the next page
-      selectedTitleIdx += maxTitlesPerPage;
-      if (selectedTitleIdx >= titles->total)
-        selectedTitleIdx = titles->total - 1;
-    } else if (input & (PAD_LEFT | PAD_L1)) {
-      // Switch to the previous page
-      selectedTitleIdx -= maxTitlesPerPage;
-      if (selectedTitleIdx < 0)
-        selectedTitleIdx = 0;
-    } else if (input & PAD_TRIANGLE) {
-      input = -1;    // Force UI loop to wait once uiTitleOptionsLoop returns
-      prevInput = 0; // Reset previous input
-      // Enter title options screen
-      if ((res = uiTitleOptionsLoop(curTarget))) {
+    // Process user inputs. Actions are triggered only by presses, navigation is also repeated while buttons are held
+    PadEvent event;
+    while (getPadEvent(&event)) {
+      if (event.type == PAD_EVENT_RELEASE)
+        continue;
+
+      int isPressed = (event.type == PAD_EVENT_PRESS);
+      if (isPressed && (event.button & (PAD_CROSS | PAD_CIRCLE))) {
+        // Make sure the title has a valid title ID
+        if (waitForTitleID(titles, curTarget))
+          continue;
+
+        // Copy target, free title list and launch
+        Target *target = copyTarget(curTarget);
+        freeTargetList(titles);
+        uiLaunchTitle(target, NULL);
         // Something went wrong, main loop must exit immediately
         return -1;
+      } else if (event.button & PAD_UP) {
+        // Point to the previous title
+        if (selectedTitleIdx > 0)
+          selectedTitleIdx--;
+      } else if (event.button & PAD_DOWN) {
+        // Advance to the next title
+        if (selectedTitleIdx < titles->total - 1)
+          selectedTitleIdx++;
+      } else if (event.button & (PAD_RIGHT | PAD_R1)) {
+        // Switch to the next page
+        selectedTitleIdx += maxTitlesPerPage;
+        if (selectedTitleIdx >= titles->total)
+          selectedTitleIdx = titles->total - 1;
+      } else if (event.button & (PAD_LEFT | PAD_L1)) {
+        // Switch to the previous page
+        selectedTitleIdx -= maxTitlesPerPage;
+        if (selectedTitleIdx < 0)
+          selectedTitleIdx = 0;
+      } else if (isPressed && (event.button & PAD_TRIANGLE)) {
+        // Make sure the title has a valid title ID
+        if (waitForTitleID(titles, curTarget))
+          continue;
+
+        // Enter title options screen
+        if ((res = uiTitleOptionsLoop(titles, curTarget))) {
+          // Something went wrong, main loop must exit immediately
+          return -1;
+        }
+        // Ignore inputs left from the title options screen
+        clearPadEvents();
+        isDirty = 1;
+      } else if (isPressed && (event.button & PAD_START)) {
+        // Quit
+        goto exit;
       }
-    } else if (input & PAD_START) {
-      // Quit
-      break;
     }
   }
 
@@ -285,51 +440,74 @@ void drawTitleListFooter(int baseX) {
   drawTextWindow(0, baseY, gsGlobal->Width - baseX, gsGlobal->Height, 0, HeaderTextColor, ALIGN_VCENTER | ALIGN_RIGHT, "Title options");
 }
 
+// Draws title name into the title list page, replacing the previous contents of the line
+static void drawTitleListPageLine(TargetList *titles, int idx, int selectedIdx) {
+  int y = getFontLineHeight() / 2 + (idx - titleListPage.firstIdx) * getFontLineHeight();
+  gsKit_prim_sprite(gsGlobal, 0, y, titleListPage.texture.Width, y + getFontLineHeight(), 0, BGColor);
+  drawText(0, y, 0, titleListPage.width, 0, ((selectedIdx == idx) ? ColorSelected : FontMainColor), titles->targets[idx]->name);
+}
+
+// Draws titles into the title list page if the page has changed.
+// Otherwise, redraws only the lines of the previously and currently selected titles
+static void updateTitleListPage(TargetList *titles, int firstIdx, int lastIdx, int selectedIdx) {
+  if ((titleListPage.firstIdx == firstIdx) && (titleListPage.selectedIdx == selectedIdx))
+    return;
+
+  beginRenderToTexture(&titleListPage.texture);
+  if (titleListPage.firstIdx != firstIdx) {
+    titleListPage.firstIdx = firstIdx;
+    gsKit_prim_sprite(gsGlobal, 0, 0, titleListPage.texture.Width, titleListPage.texture.Height, 0, BGColor);
+    for (int idx = firstIdx; idx < lastIdx; idx++)
+      drawTitleListPageLine(titles, idx, selectedIdx);
+  } else {
+    drawTitleListPageLine(titles, titleListPage.selectedIdx, selectedIdx);
+    drawTitleListPageLine(titles, selectedIdx, selectedIdx);
+  }
+  endRenderToTexture();
+  titleListPage.selectedIdx = selectedIdx;
+}
+
 // Draws title list
 void drawTitleList(TargetList *titles, int selectedTitleIdx, int maxTitlesPerPage, GSTEXTURE *selectedTitleCover) {
   int curPage = selectedTitleIdx / maxTitlesPerPage;
-
-  // Draw header and footer
-  int titleY = headerHeight;
   int baseX = keepoutArea + 10;
-  drawTextWindow(baseX, headerHeight - getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, HeaderTextColor, ALIGN_HCENTER, "Title List");
-  snprintf(lineBuffer, 255, "Page %d/%d\nTitle %d/%d", curPage + 1, DIV_ROUND(titles->total, maxTitlesPerPage), selectedTitleIdx + 1, titles->total);
-  drawTextWindow(baseX, headerHeight - getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, HeaderTextColor, ALIGN_RIGHT, lineBuffer);
-
-  drawTitleListFooter(baseX);
 
   // Draw title list
-  Target *curTitle = titles->first;
-
-  titleY += getFontLineHeight() / 2;
-  while (curTitle != NULL) {
-    // Do not display titles before the current page
-    if (curTitle->idx < maxTitlesPerPage * curPage) {
-      goto next;
-    }
-    // Do not display titles beyond the current page
-    if (curTitle->idx >= maxTitlesPerPage * (curPage + 1)) {
-      break;
-    }
-
-    // Draw title ID for selected title
-    if (selectedTitleIdx == curTitle->idx) {
-      // Draw title ID and device type under the cover art
-      drawTextWindow(coverArtX1,
-                     drawTextWindow(coverArtX1, coverArtY2 + 5, coverArtX2, 0, 0, FontMainColor, ALIGN_HCENTER,
-                                    curTitle->id), // Use y coordinate return by title ID drawing function as an argument
-                     coverArtX2, 0, 0, FontMainColor, ALIGN_HCENTER, modeToString(curTitle->deviceType));
-    }
+  int firstIdx = maxTitlesPerPage * curPage;
+  int lastIdx = maxTitlesPerPage * (curPage + 1);
+  if (lastIdx > titles->total)
+    lastIdx = titles->total;
+
+  if (titleListPage.texture.Vram != GSKIT_ALLOC_ERROR) {
+    // Draw the cached page, updating it first if needed
+    updateTitleListPage(titles, firstIdx, lastIdx, selectedTitleIdx);
+    gsGlobal->PrimAlphaEnable = GS_SETTING_OFF;
+    gsKit_prim_sprite_texture(gsGlobal, &titleListPage.texture, baseX, headerHeight, 0.0f, 0.0f, baseX + titleListPage.width,
+                              headerHeight + titleListPage.height, titleListPage.width, titleListPage.height, 0, FontMainColor);
+    gsGlobal->PrimAlphaEnable = GS_SETTING_ON;
+  } else {
+    int titleY = headerHeight + getFontLineHeight() / 2;
+    for (int idx = firstIdx; idx < lastIdx; idx++)
+      titleY =
+          drawText(baseX, titleY, 0, coverArtX1, 0, ((selectedTitleIdx == idx) ? ColorSelected : FontMainColor), titles->targets[idx]->name);
+  }
 
-    // Draw title name
-    titleY = drawText(baseX, titleY, 0, coverArtX1, 0, ((selectedTitleIdx == curTitle->idx) ? ColorSelected : FontMainColor), curTitle->name);
+  // Draw page counter. The rest of the header and footer are drawn from the persistent queue
+  snprintf(lineBuffer, 255, "Page %d/%d\nTitle %d/%d", curPage + 1, DIV_ROUND(titles->total, maxTitlesPerPage), selectedTitleIdx + 1, titles->total);
+  drawTextWindow(baseX, headerHeight - getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, HeaderTextColor, ALIGN_RIGHT, lineBuffer);
 
-  next:
-    curTitle = curTitle->next;
-  }
+  // Draw title ID and device type under the cover art
+  Target *selectedTitle = titles->targets[selectedTitleIdx];
+  char *titleID = selectedTitle->id;
+  if (titleID == NULL)
+    titleID = "Loading title ID...";
+  else if (titleID[0] == '\0')
+    titleID = "Invalid ISO";
 
-  // Draw cover art placeholder/frame
-  gsKit_prim_sprite(gsGlobal, coverArtX1 - 2, coverArtY1 - 2, coverArtX2 + 2, coverArtY2 + 2, 1, FontMainColor);
+  drawTextWindow(coverArtX1,
+                 drawTextWindow(coverArtX1, coverArtY2 + 5, coverArtX2, 0, 0, FontMainColor, ALIGN_HCENTER,
+                                titleID), // Use y coordinate return by title ID drawing function as an argument
+                 coverArtX2, 0, 0, FontMainColor, ALIGN_HCENTER, modeToString(selectedTitle->deviceType));
 
   // Draw cover art if it exists
   if (selectedTitleCover != NULL) {
@@ -369,7 +547,7 @@ void drawTitleOptionsFooter(int baseX) {
 }
 
 // Title options screen handler
-int uiTitleOptionsLoop(Target *target) {
+int uiTitleOptionsLoop(TargetList *titles, Target *target) {
   int res = 0;
   uint8_t modes = 0;
 
@@ -388,32 +566,31 @@ int uiTitleOptionsLoop(Target *target) {
   // Indexes 0 through CM_NUM_MODES are reserved for compatibility modes
   int selectedArgIdx = 0;
   int totalIndexes = (titleArguments->total - 1) + (CM_NUM_MODES - 1);
-  int input = 0;
+  PadEvent event;
 
   // Always start with the second element since the first
   // is guaranteed to be a compatibility mode flag
   Argument *curArgument = titleArguments->first->next;
 
   while (1) {
-    gsKit_clear(gsGlobal, BGColor);
+    setStaticChrome(CHROME_TITLE_OPTIONS);
 
-    // Draw header
+    // Draw title name and ID. The rest of the header and footer are drawn from the persistent queue
     int baseX = keepoutArea + 10;
     snprintf(lineBuffer, 255, "%s\n%s", target->name, target->id);
     drawTextWindow(baseX, headerHeight - getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, HeaderTextColor, ALIGN_HCENTER, lineBuffer);
-    drawTextWindow(baseX, headerHeight + 1.5 * getFontLineHeight(), gsGlobal->Width - baseX, 0, 0, FontMainColor, ALIGN_HCENTER,
-                   "Compatibility modes");
-
-    // Draw footer
-    drawTitleOptionsFooter(baseX);
 
     drawArgumentList(titleArguments, baseX, modes, selectedArgIdx);
 
     gsKit_queue_exec(gsGlobal);
     gsKit_sync_flip(gsGlobal);
 
-    // Process user inputs
-    input = waitForInput(-1);
+    // Wait for user input. Only navigation is repeated while buttons are held
+    do {
+      waitForPadEvent(&event);
+    } while ((event.type == PAD_EVENT_RELEASE) || ((event.type == PAD_EVENT_REPEAT) && !(event.button & (PAD_UP | PAD_DOWN))));
+
+    int input = event.button;
     if (input & (PAD_CROSS | PAD_CIRCLE)) {
       if (selectedArgIdx < CM_NUM_MODES) {
         // Change compat flag in bit mask and update argument value
@@ -439,8 +616,11 @@ int uiTitleOptionsLoop(Target *target) {
           curArgument = curArgument->next;
       }
     } else if (input & PAD_SQUARE) {
-      // Launch title without saving arguments
-      uiLaunchTitle(target, titleArguments);
+      // Copy target, free title list and launch title without saving arguments.
+      // Freeing the list stops all background threads that are using it
+      Target *launchTarget = copyTarget(target);
+      freeTargetList(titles);
+      uiLaunchTitle(launchTarget, titleArguments);
       res = 1; // If this was somehow reached, something went terribly wrong
       goto exit;
     } else if (input & PAD_START) {
@@ -527,7 +707,7 @@ void uiLaunchTitle(Target *target, ArgumentList *arguments) {
     arguments = loadLaunchArgumentLists(target);
   }
 
-  gsKit_clear(gsGlobal, BGColor);
+  setStaticChrome(CHROME_NONE);
 
   // Draw screen with GameID and title parameters
   snprintf(lineBuffer, 255, "Launching\n%s\n%s\n\n%s", target->name, target->id, target->fullPath);
@@ -7,9 +7,7 @@
 #include <malloc.h>
 #include <png.h>
 #include <stdlib.h>
-
-// Loads 32-bit RGBA PNG texture from memory into GSTEXTURE and uploads it to GS VRAM.
-int gsKit_texture_png_mem(GSGLOBAL *gsGlobal, GSTEXTURE *texture, void *buf, size_t size);
+#include <string.h>
 
 // Initialized in gui.c
 extern GSGLOBAL *gsGlobal;
@@ -22,12 +20,65 @@ GSTEXTURE *icons;
 // Used font
 const struct BMFont font = BMFONT_DEJAVU_SANS;
 
+// Kerning pair
+typedef struct {
+  uint32_t first;  // First character. 0 marks an empty slot
+  uint32_t second; // Second character
+  int16_t amount;  // Kerning amount
+} KerningPair;
+
+// Direct-index table of glyphs from all font buckets
+static const BMFontChar **glyphTable;
+// First character in the glyph table
+static uint32_t glyphTableStart;
+// Number of characters in the glyph table
+static uint32_t glyphTableSize;
+// Open-addressing hash table of kerning pairs
+static KerningPair *kerningTable;
+// Number of slots in the kerning table, always a power of two
+static uint32_t kerningTableSize;
+
+// Maximum number of glyphs in a single sprite run
+#define GLYPH_BATCH_SIZE 128
+
+// Glyphs collected into a single textured sprite run
+typedef struct {
+  GSPRIMUVPOINTFLAT vertices[GLYPH_BATCH_SIZE * 2]; // Top-left and bottom-right vertex of each glyph
+  int count;                                        // Number of glyphs in the batch
+  int page;                                         // Font page used by all glyphs in the batch
+  int z;                                            // Z coordinate of all glyphs in the batch
+  uint64_t color;                                   // Color of all glyphs in the batch
+} GlyphBatch;
+
+// GIF packet sizes written by gsKit, used to count queue bytes.
+// Register write: GIF tag and a single A+D register
+#define GS_REGISTER_PACKET_SIZE 32
+// Textured sprite: GIF tag, TEX0, PRIM, RGBAQ and two UV/XYZ2 pairs, padded to a quadword
+#define GS_SPRITE_PACKET_SIZE 80
+// Textured sprite run header: A+D GIF tag with TEX0, PRIM and RGBAQ followed by a REGLIST GIF tag
+#define GS_SPRITE_LIST_HEADER_SIZE 80
+
+static GlyphBatch glyphBatch;
+static DrawStats drawStats;
+
+static int initGlyphTables();
+static KerningPair *findKerningPair(uint32_t first, uint32_t second);
+static int getKerning(uint32_t first, uint32_t second);
+static void beginTextured();
+static void endTextured();
+static void batchGlyph(const BMFontChar *glyph, float x, float y, int z, uint64_t color);
+static void flushGlyphs();
+
 // Initializes and uploads font pages to GS VRAM
 int initFont() {
   if (font.pageCount == 0) {
     printf("ERROR: Invalid number of font pages\n");
     return -1;
   }
+  if (initGlyphTables()) {
+    printf("ERROR: Failed to build glyph tables\n");
+    return -1;
+  }
   fontPages = calloc(sizeof(GSTEXTURE *), font.pageCount);
 
   // Upload font pages to GS
@@ -59,9 +110,79 @@ void closeFont() {
 
   free(icons->Mem);
   free(icons);
+
+  free(glyphTable);
+  free(kerningTable);
+  glyphTable = NULL;
+  kerningTable = NULL;
+  glyphTableSize = kerningTableSize = 0;
   return;
 }
 
+// Builds glyph and kerning lookup tables from font buckets
+static int initGlyphTables() {
+  uint32_t start = UINT32_MAX;
+  uint32_t end = 0;
+  int kerningCount = 0;
+  for (int i = 0; i < font.bucketCount; i++) {
+    const BMFontBucket *bucket = &font.buckets[i];
+    if (bucket->startChar < start)
+      start = bucket->startChar;
+    if (bucket->endChar > end)
+      end = bucket->endChar;
+    for (uint32_t c = 0; c <= bucket->endChar - bucket->startChar; c++)
+      kerningCount += bucket->chars[c].kerningsCount;
+  }
+  if (start > end)
+    return -1;
+
+  glyphTableStart = start;
+  glyphTableSize = end - start + 1;
+  if ((glyphTable = calloc(glyphTableSize, sizeof(BMFontChar *))) == NULL)
+    return -1;
+
+  // Keep the kerning table at most half full
+  kerningTableSize = 16;
+  while (kerningTableSize < kerningCount * 2)
+    kerningTableSize *= 2;
+  if ((kerningTable = calloc(kerningTableSize, sizeof(KerningPair))) == NULL)
+    return -1;
+
+  for (int i = 0; i < font.bucketCount; i++) {
+    const BMFontBucket *bucket = &font.buckets[i];
+    for (uint32_t c = bucket->startChar; c <= bucket->endChar; c++) {
+      const BMFontChar *glyph = &bucket->chars[c - bucket->startChar];
+      glyphTable[c - start] = glyph;
+
+      for (int k = 0; k < glyph->kerningsCount; k++) {
+        KerningPair *pair = findKerningPair(c, glyph->kernings[k].secondChar);
+        pair->first = c;
+        pair->second = glyph->kernings[k].secondChar;
+        pair->amount += glyph->kernings[k].amount;
+      }
+    }
+  }
+  return 0;
+}
+
+// Returns the slot that contains the kerning pair or the empty slot where it should be inserted
+static KerningPair *findKerningPair(uint32_t first, uint32_t second) {
+  uint32_t mask = kerningTableSize - 1;
+  uint32_t slot = ((first * 2654435761u) ^ second) * 2654435761u;
+  for (slot = (slot >> 16) & mask; kerningTable[slot].first != 0; slot = (slot + 1) & mask) {
+    if ((kerningTable[slot].first == first) && (kerningTable[slot].second == second))
+      break;
+  }
+  return &kerningTable[slot];
+}
+
+// Returns kerning amount for the character pair
+static int getKerning(uint32_t first, uint32_t second) {
+  if ((kerningTable == NULL) || (second == '\0'))
+    return 0;
+  return findKerningPair(first, second)->amount;
+}
+
 // Returns icon height
 int getIconHeight(IconType iconType) { return ICONS[iconType].height; }
 
@@ -72,8 +193,7 @@ int getIconWidth(IconType iconType) { return ICONS[iconType].width; }
 void drawIcon(float x, float y, int z, uint64_t color, IconType iconType) {
   Icon icon = ICONS[iconType];
 
-  gsKit_set_primalpha(gsGlobal, GS_BLEND_BACK2FRONT, 0);
-  gsKit_set_test(gsGlobal, GS_ATEST_OFF);
+  beginTextured();
   gsKit_prim_sprite_texture(gsGlobal, icons,          // font page
                             x,                        // x1 (destination)
                             y,                        // y1
@@ -84,8 +204,9 @@ void drawIcon(float x, float y, int z, uint64_t color, IconType iconType) {
                             icon.x + icon.width + 1,  // u2 (source texture)
                             icon.y + icon.height + 1, // v2
                             z, color);
-  gsKit_set_test(gsGlobal, GS_ATEST_ON);
-  gsKit_set_primalpha(gsGlobal, GS_SETREG_ALPHA(0, 1, 0, 1, 0), 0);
+  drawStats.primitives++;
+  drawStats.bytes += GS_SPRITE_PACKET_SIZE;
+  endTextured();
 }
 
 // Draws the icon in [x1,y1],[x2,y2] window.
@@ -118,26 +239,68 @@ uint8_t getFontLineHeight() { return font.lineHeight; }
 
 // Returns pointer to the glyph or NULL if the font doesn't have a glyph for this character
 const BMFontChar *getGlyph(uint32_t character) {
-  for (int i = 0; i < font.bucketCount; i++) {
-    if ((font.buckets[i].startChar <= character) || (font.buckets[i].endChar >= character)) {
-      return &font.buckets[i].chars[character - font.buckets[i].startChar];
-    }
+  // Characters below glyphTableStart wrap around and are rejected by the same check
+  uint32_t idx = character - glyphTableStart;
+  if (idx >= glyphTableSize)
+    return NULL;
+  return glyphTable[idx];
+}
+
+// Sets alpha blending and disables alpha test for drawing font and icon textures
+static void beginTextured() {
+  gsKit_set_primalpha(gsGlobal, GS_BLEND_BACK2FRONT, 0);
+  gsKit_set_test(gsGlobal, GS_ATEST_OFF);
+  drawStats.bytes += 2 * GS_REGISTER_PACKET_SIZE;
+}
+
+// Submits pending glyphs and restores alpha blending and alpha test
+static void endTextured() {
+  flushGlyphs();
+  gsKit_set_test(gsGlobal, GS_ATEST_ON);
+  gsKit_set_primalpha(gsGlobal, GS_SETREG_ALPHA(0, 1, 0, 1, 0), 0);
+  drawStats.bytes += 2 * GS_REGISTER_PACKET_SIZE;
+}
+
+// Adds glyph at specified coordinates to the glyph batch.
+// The batch is submitted when the font page, Z coordinate or color changes or when it's full
+static void batchGlyph(const BMFontChar *glyph, float x, float y, int z, uint64_t color) {
+  if (glyphBatch.count &&
+      ((glyphBatch.page != glyph->page) || (glyphBatch.z != z) || (glyphBatch.color != color) || (glyphBatch.count == GLYPH_BATCH_SIZE)))
+    flushGlyphs();
+
+  if (glyphBatch.count == 0) {
+    glyphBatch.page = glyph->page;
+    glyphBatch.z = z;
+    glyphBatch.color = color;
   }
-  return NULL;
+
+  GSTEXTURE *page = fontPages[glyph->page];
+  GSPRIMUVPOINTFLAT *vertex = &glyphBatch.vertices[glyphBatch.count * 2];
+  vertex[0].xyz2 = vertex_to_XYZ2(gsGlobal, x + glyph->xoffset, y + glyph->yoffset, z);
+  vertex[0].uv = vertex_to_UV(page, glyph->x, glyph->y);
+  vertex[1].xyz2 = vertex_to_XYZ2(gsGlobal, x + glyph->xoffset + glyph->width, y + glyph->yoffset + glyph->height, z);
+  // Without +1 all characters are cut off on real hardware
+  vertex[1].uv = vertex_to_UV(page, glyph->x + glyph->width + 1, glyph->y + glyph->height + 1);
+  glyphBatch.count++;
 }
 
-// Draws glyph at specified coordinates
-static void drawGlyph(const BMFontChar *glyph, float x, float y, int z, uint64_t color) {
-  gsKit_prim_sprite_texture(gsGlobal, fontPages[glyph->page],   // font page
-                            x + glyph->xoffset,                 // x1 (destination)
-                            y + glyph->yoffset,                 // y1
-                            glyph->x,                           // u1 (source texture)
-                            glyph->y,                           // v1
-                            x + glyph->xoffset + glyph->width,  // x2 (destination)
-                            y + glyph->yoffset + glyph->height, // y2
-                            glyph->x + glyph->width + 1,        // u2 (source texture, without +1 all characters are cut off on real hardware)
-                            glyph->y + glyph->height + 1,       // v2
-                            z, color);
+// Submits all batched glyphs as a single textured sprite run
+static void flushGlyphs() {
+  if (glyphBatch.count == 0)
+    return;
+
+  gs_rgbaq color = {.rgbaq = glyphBatch.color};
+  gsKit_prim_list_sprite_texture_uv_flat_color(gsGlobal, fontPages[glyphBatch.page], color, glyphBatch.count * 2, glyphBatch.vertices);
+  drawStats.primitives++;
+  drawStats.bytes += GS_SPRITE_LIST_HEADER_SIZE + glyphBatch.count * 2 * sizeof(GSPRIMUVPOINTFLAT);
+  glyphBatch.count = 0;
+}
+
+// Returns the number of GS primitives and GIF packet bytes queued by font and icon drawing functions since the last call
+DrawStats getDrawStats() {
+  DrawStats stats = drawStats;
+  drawStats.primitives = drawStats.bytes = 0;
+  return stats;
 }
 
 // Draws the text with specified max dimensions relative to x and y
@@ -147,8 +310,7 @@ int drawText(int x, int y, int z, int maxWidth, int maxHeight, uint64_t color, c
   const BMFontChar *glyph;
 
   // Set alpha
-  gsKit_set_primalpha(gsGlobal, GS_BLEND_BACK2FRONT, 0);
-  gsKit_set_test(gsGlobal, GS_ATEST_OFF);
+  beginTextured();
 
   int curHeight = 0;
   for (int i = 0; text[i] != '\0'; i++) {
@@ -162,9 +324,9 @@ int drawText(int x, int y, int z, int maxWidth, int maxHeight, uint64_t color, c
       continue;
     }
 
-    glyph = getGlyph(text[i]);
+    glyph = getGlyph((uint8_t)text[i]);
     if (glyph == NULL) {
-      printf("WARN: Unknown character %d\n", text[i]);
+      printf("WARN: Unknown character %d\n", (uint8_t)text[i]);
       continue;
     }
 
@@ -172,22 +334,16 @@ int drawText(int x, int y, int z, int maxWidth, int maxHeight, uint64_t color, c
       break;
     }
 
-    drawGlyph(glyph, curX, y + curHeight, z, color);
+    batchGlyph(glyph, curX, y + curHeight, z, color);
     curX += glyph->xadvance;
 
     // Account for kerning if kernings are present and next char is not a null terminator
-    if (glyph->kernings && (text[i + 1] != '\0')) {
-      for (int i = 0; i < glyph->kerningsCount; i++) {
-        if (glyph->kernings[i].secondChar == text[i + 1]) {
-          curX += glyph->kernings[i].amount;
-        }
-      }
-    }
+    if (glyph->kerningsCount)
+      curX += getKerning((uint8_t)text[i], (uint8_t)text[i + 1]);
   }
 
-  // Reset alpha
-  gsKit_set_test(gsGlobal, GS_ATEST_ON);
-  gsKit_set_primalpha(gsGlobal, GS_SETREG_ALPHA(0, 1, 0, 1, 0), 0);
+  // Submit glyphs and reset alpha
+  endTextured();
 
   return (y + curHeight + font.lineHeight);
 }
@@ -201,20 +357,15 @@ float getLineWidth(const char *text) {
       return lineWidth;
     }
 
-    glyph = getGlyph(text[i]);
+    glyph = getGlyph((uint8_t)text[i]);
     if (glyph == NULL) {
       continue;
     }
 
     lineWidth += glyph->xadvance;
     // Account for kerning
-    if (glyph->kernings && (text[i + 1] != '\0')) {
-      for (int i = 0; i < glyph->kerningsCount; i++) {
-        if (glyph->kernings[i].secondChar == text[i + 1]) {
-          lineWidth += glyph->kernings[i].amount;
-        }
-      }
-    }
+    if (glyph->kerningsCount)
+      lineWidth += getKerning((uint8_t)text[i], (uint8_t)text[i + 1]);
   }
   return lineWidth;
 }
@@ -248,8 +399,7 @@ int drawTextWindow(int x1, int y1, int x2, int y2, int z, uint64_t color, uint8_
   }
 
   // Set alpha
-  gsKit_set_primalpha(gsGlobal, GS_BLEND_BACK2FRONT, 0);
-  gsKit_set_test(gsGlobal, GS_ATEST_OFF);
+  beginTextured();
 
   // Get the width of the first line
   int lineWidth = getLineWidth(text);
@@ -280,9 +430,9 @@ int drawTextWindow(int x1, int y1, int x2, int y2, int z, uint64_t color, uint8_
       continue;
     }
 
-    glyph = getGlyph(text[i]);
+    glyph = getGlyph((uint8_t)text[i]);
     if (glyph == NULL) {
-      printf("WARN: Unknown character %d\n", text[i]);
+      printf("WARN: Unknown character %d\n", (uint8_t)text[i]);
       continue;
     }
 
@@ -293,88 +443,104 @@ int drawTextWindow(int x1, int y1, int x2, int y2, int z, uint64_t color, uint8_
 
     // Skip drawing glyph if doesn't fit in the window
     if (!((curY < y1) || (curX < x1) || (x2 && (curX + 1 >= x2)))) {
-      drawGlyph(glyph, curX, curY, z, color);
+      batchGlyph(glyph, curX, curY, z, color);
     }
 
     curX += glyph->xadvance;
     // Account for kerning if kernings are present and next char is not a null terminator
-    if (glyph->kernings && (text[i + 1] != '\0')) {
-      for (int i = 0; i < glyph->kerningsCount; i++) {
-        if (glyph->kernings[i].secondChar == text[i + 1]) {
-          curX += glyph->kernings[i].amount;
-        }
-      }
-    }
+    if (glyph->kerningsCount)
+      curX += getKerning((uint8_t)text[i], (uint8_t)text[i + 1]);
   }
 
-  // Reset alpha
-  gsKit_set_test(gsGlobal, GS_ATEST_ON);
-  gsKit_set_primalpha(gsGlobal, GS_SETREG_ALPHA(0, 1, 0, 1, 0), 0);
+  // Submit glyphs and reset alpha
+  endTextured();
 
   return curY + font.lineHeight;
 }
 
-// Loads 32-bit RGBA PNG texture from memory into GSTEXTURE and uploads it to GS VRAM.
-// Code based on gsToolkit.
-int gsKit_texture_png_mem(GSGLOBAL *gsGlobal, GSTEXTURE *texture, void *buf, size_t size) {
-  FILE *file = fmemopen(buf, size, "rb");
-  if (file == NULL) {
-    printf("ERROR: Failed to load PNG file\n");
-    return -1;
+// PNG data source for libpng read callback
+typedef struct {
+  uint8_t *data; // PNG data
+  size_t size;   // PNG data size
+  size_t offset; // Current read offset
+} PNGSource;
+
+// Reads length bytes of PNG data
+static void readPNGData(png_structp png_ptr, png_bytep data, png_size_t length) {
+  PNGSource *source = png_get_io_ptr(png_ptr);
+  if (length > source->size - source->offset)
+    png_error(png_ptr, "Unexpected end of PNG data");
+
+  memcpy(data, &source->data[source->offset], length);
+  source->offset += length;
+}
+
+// Converts 8-bit PNG alpha of count RGBA pixels into the GS alpha range in place, one pixel word at a time
+static void convertAlpha(uint32_t *pixels, int count) {
+  for (int i = 0; i < count; i++) {
+    uint32_t alpha = pixels[i] >> 24;
+    pixels[i] = (pixels[i] & 0x00FFFFFF) | ((128 - (alpha * 128 / 255)) << 24);
   }
+}
 
+// Decodes PNG texture from memory into GSTEXTURE and uploads it to GS VRAM unless the texture is delayed.
+// RGB, paletted and greyscale images are expanded to 32-bit RGBA.
+// Rows are decoded directly into texture memory, so no intermediate buffers are allocated.
+// Code based on gsToolkit.
+int gsKit_texture_png_mem(GSGLOBAL *gsGlobal, GSTEXTURE *texture, void *buf, size_t size) {
+  PNGSource source = {.data = buf, .size = size, .offset = 0};
   png_structp png_ptr;
   png_infop info_ptr;
   png_uint_32 width, height;
-  png_bytep *row_pointers;
-
-  uint32_t sig_read = 0;
-  int row, i, k = 0, j, bit_depth, color_type, interlace_type;
+  int bit_depth, color_type, interlace_type;
 
   png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, NULL, NULL);
-
   if (!png_ptr) {
     printf("ERROR: Failed to init libpng read struct\n");
-    fclose(file);
     return -1;
   }
 
   info_ptr = png_create_info_struct(png_ptr);
-
   if (!info_ptr) {
     printf("ERROR: Failed to init libpng info struct\n");
-    fclose(file);
     png_destroy_read_struct(&png_ptr, (png_infopp)NULL, (png_infopp)NULL);
     return -1;
   }
 
+  texture->Mem = NULL;
   if (setjmp(png_jmpbuf(png_ptr))) {
-    printf("ERROR: Failed to setup libpng long jump\n");
+    printf("ERROR: Failed to decode PNG\n");
     png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
-    fclose(file);
+    free(texture->Mem);
+    texture->Mem = NULL;
     return -1;
   }
 
-  png_init_io(png_ptr, file);
-  png_set_sig_bytes(png_ptr, sig_read);
+  png_set_read_fn(png_ptr, &source, readPNGData);
   png_read_info(png_ptr, info_ptr);
   png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
 
-  if (color_type != PNG_COLOR_TYPE_RGB_ALPHA) {
-    printf("ERROR: Only 32-bit RGBA textures are supported\n");
-    png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
-    fclose(file);
-    return -1;
-  }
-
+  // Expand every color type to 8-bit RGBA
+  if (color_type == PNG_COLOR_TYPE_PALETTE)
+    png_set_palette_to_rgb(png_ptr);
+  if ((color_type == PNG_COLOR_TYPE_GRAY) && (bit_depth < 8))
+    png_set_expand_gray_1_2_4_to_8(png_ptr);
+  if ((color_type == PNG_COLOR_TYPE_GRAY) || (color_type == PNG_COLOR_TYPE_GRAY_ALPHA))
+    png_set_gray_to_rgb(png_ptr);
   if (bit_depth == 16)
     png_set_strip_16(png_ptr);
-
   if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
     png_set_tRNS_to_alpha(png_ptr);
+  else if (!(color_type & PNG_COLOR_MASK_ALPHA))
+    png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
 
-  png_set_filler(png_ptr, 0xff, PNG_FILLER_AFTER);
+  int passes = png_set_interlace_handling(png_ptr);
   png_read_update_info(png_ptr, info_ptr);
+  if (png_get_rowbytes(png_ptr, info_ptr) != width * 4) {
+    printf("ERROR: Unsupported PNG format\n");
+    png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
+    return -1;
+  }
 
   texture->Width = width;
   texture->Height = height;
@@ -382,39 +548,29 @@ int gsKit_texture_png_mem(GSGLOBAL *gsGlobal, GSTEXTURE *texture, void *buf, siz
   texture->Clut = NULL;
   texture->PSM = GS_PSM_CT32;
   texture->Filter = GS_FILTER_NEAREST;
-  texture->Mem = memalign(128, gsKit_texture_size(texture->Width, texture->Height, texture->PSM));
-
-  int row_bytes = png_get_rowbytes(png_ptr, info_ptr);
-  row_pointers = calloc(height, sizeof(png_bytep));
-  for (row = 0; row < height; row++)
-    row_pointers[row] = malloc(row_bytes);
-
-  png_read_image(png_ptr, row_pointers);
-
-  struct pixel {
-    uint8_t r, g, b, a;
-  };
-  struct pixel *pixels = (struct pixel *)texture->Mem;
-
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      pixels[k].r = row_pointers[i][4 * j];
-      pixels[k].g = row_pointers[i][4 * j + 1];
-      pixels[k].b = row_pointers[i][4 * j + 2];
-      pixels[k++].a = 128 - ((int)row_pointers[i][4 * j + 3] * 128 / 255);
-    }
+  texture->Mem = memalign(128, gsKit_texture_size_ee(texture->Width, texture->Height, texture->PSM));
+  if (texture->Mem == NULL) {
+    printf("ERROR: Failed to allocate texture memory\n");
+    png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
+    return -1;
   }
 
-  for (row = 0; row < height; row++)
-    free(row_pointers[row]);
+  // Decode rows in place, converting alpha once the row is complete
+  for (int pass = 0; pass < passes; pass++) {
+    for (int row = 0; row < height; row++) {
+      uint32_t *pixels = &texture->Mem[row * width];
+      png_read_row(png_ptr, (png_bytep)pixels, NULL);
+      if (pass == passes - 1)
+        convertAlpha(pixels, width);
+    }
+  }
 
-  free(row_pointers);
   png_read_end(png_ptr, NULL);
   png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
-  fclose(file);
 
-  // Upload texture to GS
-  gsKit_TexManager_bind(gsGlobal, texture);
+  // Upload texture to GS. Delayed textures are only decoded into EE RAM
+  if (!texture->Delayed)
+    gsKit_TexManager_bind(gsGlobal, texture);
 
   return 0;
 }
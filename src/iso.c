@@ -5,210 +5,737 @@
 #include "iso_title_id.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <fileXio_rpc.h>
+#include <io_common.h>
+#include <kernel.h>
+#include <malloc.h>
 #include <ps2sdkapi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
-int _findISO(DIR *directory, TargetList *result);
-void insertIntoList(TargetList *result, Target *title);
+// Title list entry with precomputed collation key
+typedef struct {
+  char *key;      // Uppercase title name used for sorting
+  int order;      // Discovery order, used to keep titles with the same name in order
+  Target *target; // Discovered target
+} ScanEntry;
+
+// Growable array of targets discovered on BDM devices
+typedef struct {
+  int total;          // Total number of entries
+  int capacity;       // Number of allocated entries
+  ScanEntry *entries; // Entry array
+  Arena arena;        // Arena used to allocate targets and their strings
+  Arena keyArena;     // Arena used to allocate collation keys
+} ScanResult;
+
+// Arena block sizes
+#define TARGET_ARENA_BLOCK_SIZE 32768
+#define KEY_ARENA_BLOCK_SIZE 16384
+
+// Directory stack entry used by the directory walker
+typedef struct {
+  int recordOffset; // Offset of the directory record in the directory cache
+  int entryOffset;  // Offset of the next record entry relative to the record start
+  int remaining;    // Number of record entries left to process
+  int pathLen;      // Length of the directory path in the path buffer
+  int isReused;     // Set if the directory record has been reused from the previous scan
+} WalkerFrame;
+
+// Per-device scan worker
+typedef struct {
+  char mountpoint[sizeof(MASS_PLACEHOLDER)]; // Device mountpoint
+  int isFullRescan;                          // Set to read all directories instead of reusing the directory cache
+  ScanResult result;                         // Targets discovered on the device
+  int status;                                // Scan result code
+  clock_t time;                              // Time spent scanning the device
+  int threadID;                              // Worker thread ID. Negative if the device was scanned in the calling thread
+  void *stack;                               // Worker thread stack
+  int doneSema;                              // Semaphore signalled when the worker finishes
+} ScanWorker;
+
+// Worker thread stack size
+#define SCAN_THREAD_STACK_SIZE 0x8000
+
+// Background title ID resolver state
+typedef struct {
+  TargetList *list;             // Target list being processed
+  int pending;                  // Number of targets without a title ID
+  int cursor;                   // Index of the first target that might still be pending
+  volatile int focusIdx;        // Index of the title selected in the UI
+  volatile int isStopRequested; // Set to stop the resolver after the current title
+  volatile int isDone;          // Set once the resolver has finished
+  int threadID;                 // Resolver thread ID. Negative if the thread is not running
+  void *stack;                  // Resolver thread stack
+  int doneSema;                 // Semaphore signalled when the resolver finishes
+} TitleIDResolver;
+
+// Resolver thread stack size
+#define RESOLVER_THREAD_STACK_SIZE 0x8000
+// Number of titles around the focused title that are resolved before the rest of the list
+#define RESOLVER_FOCUS_WINDOW 32
+// Interval between title ID checks while waiting for the resolver, in microseconds
+#define RESOLVER_POLL_INTERVAL 10000
+
+// Background target list validator state
+typedef struct {
+  TargetList *list;    // Target list loaded from the snapshot
+  TargetList *result;  // Target list built from the devices. NULL if it's the same as the snapshot
+  int pending;         // Number of targets in result that don't have a title ID
+  volatile int isDone; // Set once the validator has finished
+  int threadID;        // Validator thread ID. Negative if the thread is not running
+  void *stack;         // Validator thread stack
+  int doneSema;        // Semaphore signalled when the validator finishes
+} TargetListValidator;
+
+// Validator thread stack size
+#define VALIDATOR_THREAD_STACK_SIZE 0x8000
+
+extern void *_gp;
+
+static TitleIDResolver resolver = {.threadID = -1};
+static TargetListValidator validator = {.threadID = -1};
+// Set to abort device scans and list reconciliation done by the validator
+static volatile int isScanCancelled = 0;
+// Title ID assigned to targets that don't have a valid SYSTEM.CNF
+static char invalidTitleID[] = "";
+
+int _findISO(const char *mountpoint, int isFullRescan, ScanResult *result);
+int readDirectory(char *path, int mountpointLen, uint32_t mtime, DirectoryCache *cache, DirectoryCache *newCache, int *reused);
+static uint32_t packModificationTime(unsigned char *mtime);
+int addDirectoryTargets(char *path, int pathLen, DirCacheRecord *record, ScanResult *result);
+int startScanWorker(ScanWorker *worker, int priority);
+void initScanResult(ScanResult *result);
+int appendScanEntry(ScanResult *result, Target *title);
+int mergeScanResult(ScanResult *dst, ScanResult *src);
+void freeScanResult(ScanResult *result);
+void buildTargetList(ScanResult *scan, TargetList *result);
 void processTitleID(TargetList *result);
+int loadCachedTitleIDs(TargetList *result);
+TargetList *newTargetList();
+TargetList *scanTargets(int isFullRescan);
+static void startTitleIDResolution(TargetList *list, int pending);
+static int startTargetListValidator(TargetList *list);
+static void targetListValidatorThread(void *arg);
+static void stopTargetListValidator(int cancel);
+static int reconcileTargetList(TargetList *snapshot, TargetList *result);
+static int startTitleIDResolver();
+static void titleIDResolverThread(void *arg);
+static void stopTitleIDResolver();
+static void resolveTitleIDs();
 
 // Directories to skip when browsing for ISOs
 const char *ignoredDirs[] = {
     "nhddl", "APPS", "ART", "CFG", "CHT", "LNG", "THM", "VMC", "XEBPLUS",
 };
 
-// Generates a list of launch candidates found on BDM devices
+// Generates a list of launch candidates found on BDM devices.
+// If the target list snapshot from the previous launch is available, it's returned right away
+// and validated against the devices in the background.
 // Returns NULL if no targets were found or an error occurs
 TargetList *findISO() {
-  DIR *directory;
+  TargetList *result = newTargetList();
+  if (result == NULL)
+    return NULL;
+
+  clock_t start = clock();
+  if (!loadTargetListSnapshot(result)) {
+    logString("Loaded %d titles from the target list snapshot in %d ms\n", result->total,
+              (int)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+    if (!startTargetListValidator(result))
+      return result;
+  }
+  freeTargetList(result);
+
+  // The result is shown and saved as the snapshot right away, so don't rely on directory modification time
+  if ((result = scanTargets(1)) == NULL)
+    return NULL;
+
+  processTitleID(result);
+  return result;
+}
+
+// Allocates an empty target list
+TargetList *newTargetList() {
   TargetList *result = malloc(sizeof(TargetList));
-  char mountpoint[] = MASS_PLACEHOLDER;
+  if (result == NULL)
+    return NULL;
+
   result->total = 0;
+  result->targets = NULL;
   result->first = NULL;
   result->last = NULL;
+  arenaInit(&result->arena, TARGET_ARENA_BLOCK_SIZE);
+  return result;
+}
 
+// Scans all BDM devices and returns a sorted list of discovered targets without title IDs.
+// If isFullRescan is set, all directories are read again instead of being reused from the directory cache.
+// Returns NULL if no targets were found or an error occurs
+TargetList *scanTargets(int isFullRescan) {
+  TargetList *result = newTargetList();
+  if (result == NULL)
+    return NULL;
+
+  ScanResult scan;
+  ScanWorker workers[MAX_MASS_DEVICES];
+  initScanResult(&scan);
+
+  // Run worker threads with the same priority as the calling thread
+  // so device scans can interleave while other workers wait for I/O
+  ee_thread_status_t threadStatus;
+  int priority = 0;
+  if (ReferThreadStatus(GetThreadId(), &threadStatus) >= 0)
+    priority = threadStatus.current_priority;
+
+  ee_sema_t sema = {.init_count = 0, .max_count = MAX_MASS_DEVICES, .option = 0};
+  int doneSema = CreateSema(&sema);
+
+  // Start one worker per mapped device
+  int deviceCount = 0;
   for (int i = 0; i < MAX_MASS_DEVICES; i++) {
     if (deviceModeMap[i].mode == MODE_ALL) {
       break;
     }
-    mountpoint[4] = i + '0';
+    ScanWorker *worker = &workers[i];
+    memset(worker, 0, sizeof(ScanWorker));
+    strcpy(worker->mountpoint, MASS_PLACEHOLDER);
+    worker->mountpoint[4] = i + '0';
+    worker->isFullRescan = isFullRescan;
+    initScanResult(&worker->result);
+    worker->doneSema = doneSema;
+    worker->threadID = -1;
+    deviceCount++;
 
-    directory = opendir(mountpoint);
-    // Check if the directory can be opened
-    if (directory == NULL) {
-      logString("ERROR: Can't open %s\n", mountpoint);
-      return NULL;
+    if ((doneSema < 0) || startScanWorker(worker, priority)) {
+      // Fall back to scanning the device in the calling thread
+      clock_t start = clock();
+      worker->status = _findISO(worker->mountpoint, worker->isFullRescan, &worker->result);
+      worker->time = clock() - start;
     }
+  }
+
+  // Wait for all worker threads to finish
+  for (int i = 0; i < deviceCount; i++) {
+    if (workers[i].threadID < 0)
+      continue;
+
+    WaitSema(doneSema);
+  }
+  if (doneSema >= 0)
+    DeleteSema(doneSema);
 
-    chdir(mountpoint);
-    if (_findISO(directory, result)) {
-      free(result);
-      closedir(directory);
-      return NULL;
+  // Merge partial results in device order
+  int res = 0;
+  for (int i = 0; i < deviceCount; i++) {
+    ScanWorker *worker = &workers[i];
+    if (worker->threadID >= 0) {
+      TerminateThread(worker->threadID);
+      DeleteThread(worker->threadID);
+      free(worker->stack);
     }
-    closedir(directory);
+
+    logString("Found %d titles on %s in %d ms\n", worker->result.total, worker->mountpoint,
+              (int)(worker->time * 1000 / CLOCKS_PER_SEC));
+    if (!res && !(res = worker->status))
+      res = mergeScanResult(&scan, &worker->result);
+    freeScanResult(&worker->result);
+  }
+  if (res) {
+    freeScanResult(&scan);
+    free(result);
+    return NULL;
+  }
+
+  // Sort all discovered titles at once and link them into the target list
+  clock_t sortStart = clock();
+  buildTargetList(&scan, result);
+  logString("Sorted %d titles in %d ms\n", result->total, (int)((clock() - sortStart) * 1000 / CLOCKS_PER_SEC));
+  if (result->total == 0) {
+    freeTargetList(result);
+    return NULL;
   }
-  processTitleID(result);
 
-  // Set indexes for each title
+  // Build target array and set indexes for each title
+  result->targets = arenaAlloc(&result->arena, sizeof(Target *) * result->total);
+  if (result->targets == NULL) {
+    logString("ERROR: Can't allocate enough memory\n");
+    freeTargetList(result);
+    return NULL;
+  }
   int idx = 0;
   Target *curTitle = result->first;
   while (curTitle != NULL) {
     curTitle->idx = idx;
+    result->targets[idx] = curTitle;
     idx++;
     curTitle = curTitle->next;
   }
-
   return result;
 }
 
-// Searches rootpath and adds discovered ISOs to TargetList
-int _findISO(DIR *directory, TargetList *result) {
-  if (directory == NULL)
-    return -ENOENT;
+// Scans the worker device and signals worker semaphore once done
+static void scanWorkerThread(void *arg) {
+  ScanWorker *worker = (ScanWorker *)arg;
 
-  // Read directory entries
-  struct dirent *entry;
-  char *fileext;
-  char titlePath[PATH_MAX + 1];
-  if (!getcwd(titlePath, PATH_MAX + 1)) { // Initialize titlePath with current working directory
-    logString("ERROR: Failed to get cwd\n");
-    return -ENOENT;
+  clock_t start = clock();
+  worker->status = _findISO(worker->mountpoint, worker->isFullRescan, &worker->result);
+  worker->time = clock() - start;
+
+  SignalSema(worker->doneSema);
+  ExitThread();
+}
+
+// Creates and starts the scan worker thread
+int startScanWorker(ScanWorker *worker, int priority) {
+  worker->stack = memalign(16, SCAN_THREAD_STACK_SIZE);
+  if (worker->stack == NULL)
+    return -ENOMEM;
+
+  ee_thread_t thread = {
+      .func = scanWorkerThread,
+      .stack = worker->stack,
+      .stack_size = SCAN_THREAD_STACK_SIZE,
+      .gp_reg = &_gp,
+      .initial_priority = priority,
+      .attr = 0,
+      .option = 0,
+  };
+  int threadID = CreateThread(&thread);
+  if (threadID < 0) {
+    printf("ERROR: Failed to create scan thread for %s: %d\n", worker->mountpoint, threadID);
+    free(worker->stack);
+    worker->stack = NULL;
+    return threadID;
   }
 
-  int cwdLen = strlen(titlePath); // Get the length of base path string
-  while ((entry = readdir(directory)) != NULL) {
-    // Check if the entry is a directory using d_type
-    switch (entry->d_type) {
-    case DT_DIR:
-      // Ignore hidden, special and invalid directories (non-ASCII paths seem to return '?' and cause crashes when used with opendir)
-      if ((entry->d_name[0] == '.') || (entry->d_name[0] == '$') || (entry->d_name[0] == '?'))
+  worker->threadID = threadID;
+  StartThread(threadID, worker);
+  return 0;
+}
+
+// Searches the device at mountpoint and adds discovered ISOs to ScanResult.
+// Walks the directory tree iteratively using an explicit directory stack and a single path buffer,
+// opening every directory by its full path without changing the current working directory.
+// Contents of directories that haven't been modified since the previous scan are loaded from the directory cache
+// unless isFullRescan is set or the last scan that read all directories is older than DIR_CACHE_FULL_READ_INTERVAL.
+// The directory cache is updated in both cases.
+int _findISO(const char *mountpoint, int isFullRescan, ScanResult *result) {
+  char path[PATH_MAX + 1];
+  strlcpy(path, mountpoint, PATH_MAX + 1);
+  int mountpointLen = strlen(path);
+
+  // Load directory cache from the previous scan
+  DirectoryCache cache;
+  DirectoryCache newCache = {0};
+  if (loadDirectoryCache(&cache, mountpoint))
+    printf("Directory cache for %s is not available, all directories will be read\n", mountpoint);
+  // Read all directories periodically since directory modification time is not always updated.
+  // Keep the loaded cache to avoid rewriting it if nothing has changed
+  uint32_t now = (uint32_t)time(NULL);
+  if (!cache.fullReadTime || (now < cache.fullReadTime) || (now - cache.fullReadTime >= DIR_CACHE_FULL_READ_INTERVAL))
+    isFullRescan = 1;
+  newCache.fullReadTime = (isFullRescan) ? now : cache.fullReadTime;
+  DirectoryCache *reusableCache = (isFullRescan) ? NULL : &cache;
+
+  int stackSize = 16;
+  WalkerFrame *stack = malloc(sizeof(WalkerFrame) * stackSize);
+  if (stack == NULL) {
+    freeDirectoryCache(&cache);
+    return -ENOMEM;
+  }
+
+  // Scan the whole device unless scan paths are set
+  ScanFilter *filter = &LAUNCHER_OPTIONS.scanFilter;
+  static char *deviceRoot[] = {""};
+  char **scanPaths = deviceRoot;
+  int scanPathCount = 1;
+  if (filter->pathCount) {
+    scanPaths = filter->paths;
+    scanPathCount = filter->pathCount;
+  }
+
+  int res = 0;
+  int depth = 0;
+  int reused = 0;
+  int scanPathIdx = 0;
+  int offset;
+  int reusedBefore;
+  uint32_t mtime;
+  WalkerFrame *frame;
+  DirCacheRecord *record;
+  char *entry;
+  while (1) {
+    // Stop between directories if the scan has been cancelled
+    if (isScanCancelled) {
+      res = -ECANCELED;
+      goto out;
+    }
+
+    if (depth == 0) {
+      if (scanPathIdx == scanPathCount) // All scan paths have been processed
+        break;
+
+      // Read the next scan path
+      path[mountpointLen] = '\0';
+      if (mountpointLen + strlen(scanPaths[scanPathIdx]) > PATH_MAX) {
+        scanPathIdx++;
+        continue;
+      }
+      strcat(path, scanPaths[scanPathIdx++]);
+      reusedBefore = reused;
+      if ((offset = readDirectory(path, mountpointLen, 0, reusableCache, &newCache, &reused)) < 0) {
+        if (filter->pathCount && (offset != -ENOMEM)) {
+          // Scan path doesn't have to exist on every device
+          printf("WARN: Can't open %s\n", path);
+          continue;
+        }
+        logString("ERROR: Can't open %s\n", path);
+        res = offset;
+        goto out;
+      }
+    } else {
+      frame = &stack[depth - 1];
+      path[frame->pathLen] = '\0'; // Truncate path to the current directory
+
+      if (frame->remaining == 0) {
+        // Directory has been processed, return to the parent directory
+        depth--;
+        continue;
+      }
+
+      // Get next directory entry
+      record = getDirectoryRecord(&newCache, frame->recordOffset);
+      entry = (char *)record + frame->entryOffset;
+      frame->entryOffset = getNextDirectoryRecordEntry(entry) - (char *)record;
+      frame->remaining--;
+      if (entry[0] != DIR_CACHE_DIR)
         continue;
 
       for (int i = 0; i < sizeof(ignoredDirs) / sizeof(char *); i++) {
-        if (!strcmp(ignoredDirs[i], entry->d_name)) {
+        if (!strcmp(ignoredDirs[i], &entry[1])) {
           goto skipDirectory;
         }
       }
 
-      // Open dir and change cwd
-      DIR *d = opendir(entry->d_name);
-      chdir(entry->d_name);
-      // Process inner directory recursively
-      _findISO(d, result);
-      // Return back to root directory
-      chdir("..");
-      closedir(d);
-    skipDirectory:
-      continue;
-    default:
-      if (entry->d_name[0] == '.') // Ignore .files (most likely macOS doubles)
+      // Make sure the full directory path fits into the path buffer
+      if (frame->pathLen + strlen(&entry[1]) + 1 > PATH_MAX) {
+        printf("WARN: Skipping %s/%s, path is too long\n", path, &entry[1]);
+        continue;
+      }
+
+      // Append directory name to the path and skip the directory if it's excluded
+      strcat(path, "/");
+      strcat(path, &entry[1]);
+      if (isDirectoryExcluded(filter, &path[mountpointLen], &entry[1]))
+        continue;
+
+      // Read the directory.
+      // Modification time stored in a freshly read parent is up to date and doesn't have to be requested again
+      mtime = (frame->isReused) ? 0 : getDirectoryRecordEntryMtime(entry);
+      reusedBefore = reused;
+      if ((offset = readDirectory(path, mountpointLen, mtime, reusableCache, &newCache, &reused)) < 0) {
+        if (offset == -ENOMEM) {
+          res = offset;
+          goto out;
+        }
+        printf("WARN: Can't open %s\n", path);
+        continue;
+      }
+    }
+
+    // Add ISOs from the directory
+    record = getDirectoryRecord(&newCache, offset);
+    if ((res = addDirectoryTargets(path, strlen(path), record, result))) {
+      logString("ERROR: Can't allocate enough memory\n");
+      goto out;
+    }
+
+    // Grow the stack if needed
+    if (depth == stackSize) {
+      WalkerFrame *newStack = realloc(stack, sizeof(WalkerFrame) * stackSize * 2);
+      if (newStack == NULL) {
+        res = -ENOMEM;
+        goto out;
+      }
+      stack = newStack;
+      stackSize *= 2;
+    }
+
+    // Process subdirectories on the next iterations
+    stack[depth].recordOffset = offset;
+    stack[depth].entryOffset = sizeof(DirCacheRecord) + record->pathLength;
+    stack[depth].remaining = record->nameCount;
+    stack[depth].pathLen = strlen(path);
+    stack[depth].isReused = (reused != reusedBefore);
+    depth++;
+  skipDirectory:
+    continue;
+  }
+
+  printf("Reused %d of %d directories on %s from cache\n", reused, newCache.total, mountpoint);
+  // Update directory cache if anything has changed
+  if (!isDirectoryCacheEqual(&cache, &newCache) && storeDirectoryCache(&newCache, mountpoint)) {
+    printf("ERROR: Failed to save directory cache for %s\n", mountpoint);
+  }
+
+out:
+  freeDirectoryCache(&cache);
+  freeDirectoryCache(&newCache);
+  free(stack);
+  return res;
+}
+
+// Adds directory at path to the new directory cache and returns the record offset or a negative error.
+// mtime is the directory modification time reported by the parent directory or 0 if it must be requested.
+// Reuses the record from cache if directory modification time is known and hasn't changed. cache can be NULL.
+int readDirectory(char *path, int mountpointLen, uint32_t mtime, DirectoryCache *cache, DirectoryCache *newCache, int *reused) {
+  // Get directory modification time
+  iox_stat_t st;
+  if (!mtime && (fileXioGetStat(path, &st) >= 0))
+    mtime = packModificationTime(st.mtime);
+
+  // Reuse cached directory contents if directory hasn't been modified
+  DirCacheRecord *record = (cache != NULL) ? getCachedDirectory(cache, &path[mountpointLen], mtime) : NULL;
+  if (record != NULL) {
+    (*reused)++;
+    return copyDirectoryRecord(newCache, record);
+  }
+
+  int fd = fileXioDopen(path);
+  if (fd < 0)
+    return -ENOENT;
+
+  int offset = beginDirectoryRecord(newCache, &path[mountpointLen], mtime);
+  if (offset < 0) {
+    fileXioDclose(fd);
+    return offset;
+  }
+
+  // Read directory entries
+  int res = 0;
+  iox_dirent_t entry;
+  char *fileext;
+  while (fileXioDread(fd, &entry) > 0) {
+    if (FIO_S_ISDIR(entry.stat.mode)) {
+      // Ignore hidden, special and invalid directories (non-ASCII paths seem to return '?' and cause crashes when used with opendir)
+      if ((entry.name[0] == '.') || (entry.name[0] == '$') || (entry.name[0] == '?'))
+        continue;
+
+      // Store the modification time so the subdirectory doesn't have to be queried separately
+      res = appendDirectoryRecordEntry(newCache, offset, DIR_CACHE_DIR, entry.name, 0, packModificationTime(entry.stat.mtime));
+    } else {
+      if (entry.name[0] == '.') // Ignore .files (most likely macOS doubles)
         continue;
 
       // Make sure file has .iso extension
-      fileext = strrchr(entry->d_name, '.');
+      fileext = strrchr(entry.name, '.');
       if ((fileext != NULL) && (!strcmp(fileext, ".iso") || !strcmp(fileext, ".ISO"))) {
-        // Generate full path
-        if (titlePath[cwdLen - 1] != '/')
-          strcat(titlePath, "/");
-        strcat(titlePath, entry->d_name);
-
-        // Initialize target
-        Target *title = calloc(sizeof(Target), 1);
-        title->prev = NULL;
-        title->next = NULL;
-        title->fullPath = strdup(titlePath);
-        title->deviceType = deviceModeMap[titlePath[4] - '0'].mode;
-
-        // Get file name without the extension
-        int nameLength = (int)(fileext - entry->d_name);
-        title->name = calloc(sizeof(char), nameLength + 1);
-        strncpy(title->name, entry->d_name, nameLength);
-
-        // Increment title counter and update target list
-        result->total++;
-        if (result->first == NULL) {
-          // If this is the first entry, update both pointers
-          result->first = title;
-          result->last = title;
-        } else {
-          insertIntoList(result, title);
-        }
-        titlePath[cwdLen] = '\0'; // reset titlePath by ending string on base path
+        // File size is reported by the directory entry, so it doesn't need to be requested separately
+        res = appendDirectoryRecordEntry(newCache, offset, DIR_CACHE_FILE, entry.name,
+                                         ((uint64_t)entry.stat.hisize << 32) | entry.stat.size, 0);
       }
     }
+
+    if (res) {
+      fileXioDclose(fd);
+      return res;
+    }
   }
+  fileXioDclose(fd);
+
+  endDirectoryRecord(newCache, offset);
+  return offset;
+}
+
+// Packs iox modification time into a 32-bit value that changes whenever the time changes.
+// Returns 0 if modification time is not available
+static uint32_t packModificationTime(unsigned char *mtime) {
+  // iox time is stored as unused byte, seconds, minutes, hours, day, month and little-endian year
+  uint32_t year = mtime[6] | (mtime[7] << 8);
+  return ((year & 0x3F) << 26) | ((mtime[5] & 0xF) << 22) | ((mtime[4] & 0x1F) << 17) | ((mtime[3] & 0x1F) << 12) |
+         ((mtime[2] & 0x3F) << 6) | (mtime[1] & 0x3F);
+}
+
+// Adds all ISOs from the directory record to ScanResult
+int addDirectoryTargets(char *path, int pathLen, DirCacheRecord *record, ScanResult *result) {
+  char *entry = (char *)(record + 1) + record->pathLength;
+  char *fileext;
+  for (int i = 0; i < record->nameCount; i++, entry = getNextDirectoryRecordEntry(entry)) {
+    if (entry[0] != DIR_CACHE_FILE)
+      continue;
+
+    // Make sure the full title path fits into the path buffer
+    if (pathLen + strlen(&entry[1]) + 1 > PATH_MAX) {
+      printf("WARN: Skipping %s/%s, path is too long\n", path, &entry[1]);
+      continue;
+    }
+
+    // Generate full path
+    strcat(path, "/");
+    strcat(path, &entry[1]);
+
+    // Initialize target
+    Target *title = arenaAlloc(&result->arena, sizeof(Target));
+    if (title == NULL)
+      return -ENOMEM;
+    title->fullPath = arenaStrdup(&result->arena, path);
+    title->size = getDirectoryRecordEntrySize(entry);
+    title->deviceType = deviceModeMap[path[4] - '0'].mode;
+    path[pathLen] = '\0'; // Reset path to the directory
+
+    // Get file name without the extension
+    fileext = strrchr(&entry[1], '.');
+    title->name = arenaStrndup(&result->arena, &entry[1], fileext - &entry[1]);
 
+    // Add title to the scan result
+    if ((title->fullPath == NULL) || (title->name == NULL) || appendScanEntry(result, title))
+      return -ENOMEM;
+  }
   return 0;
 }
 
 // Converts lowercase ASCII string into uppercase
 void toUppercase(char *str) {
-  for (int i = 0; i <= strlen(str); i++)
-    if (str[i] >= 0x61 && str[i] <= 0x7A) {
-      str[i] -= 32;
+  for (; *str != '\0'; str++)
+    if (*str >= 0x61 && *str <= 0x7A) {
+      *str -= 32;
     }
 }
 
-// Inserts title in the list while keeping the alphabetical order
-void inline insertIntoList(TargetList *result, Target *title) {
-  // Traverse the list in reverse
-  Target *curTitle = result->last;
+// Initializes empty scan result
+void initScanResult(ScanResult *result) {
+  result->total = 0;
+  result->capacity = 0;
+  result->entries = NULL;
+  arenaInit(&result->arena, TARGET_ARENA_BLOCK_SIZE);
+  arenaInit(&result->keyArena, KEY_ARENA_BLOCK_SIZE);
+}
 
-  // Covert title name to uppercase
-  char *curUppercase = strdup(title->name);
-  toUppercase(curUppercase);
+// Appends title to the scan result, computing the collation key once
+int appendScanEntry(ScanResult *result, Target *title) {
+  if (result->total == result->capacity) {
+    // Double the capacity to keep appends amortized O(1)
+    int capacity = (result->capacity) ? result->capacity * 2 : 64;
+    ScanEntry *entries = realloc(result->entries, sizeof(ScanEntry) * capacity);
+    if (entries == NULL)
+      return -ENOMEM;
 
-  // Overall, title name should not exceed PATH_MAX
-  char lastUppercase[PATH_MAX];
+    result->entries = entries;
+    result->capacity = capacity;
+  }
 
-  while (1) {
-    // Reset string buffer
-    lastUppercase[0] = '\0';
-    // Convert name of the last title to uppercase
-    strlcpy(lastUppercase, curTitle->name, PATH_MAX);
-    toUppercase(lastUppercase);
-
-    // Compare new title name and the current title name
-    if (strcmp(curUppercase, lastUppercase) >= 0) {
-      // First letter of the new title is after or the same as the current one
-      // New title must be inserted after the current list element
-      if (curTitle->next != NULL) {
-        // Current title has a next title, update the next element
-        curTitle->next->prev = title;
-        title->next = curTitle->next;
-      } else {
-        // Current title has no next title (it's the last list element)
-        result->last = title;
-      }
-      title->prev = curTitle;
-      curTitle->next = title;
-      break;
-    }
+  // Convert title name to uppercase
+  char *key = arenaStrdup(&result->keyArena, title->name);
+  if (key == NULL)
+    return -ENOMEM;
+  toUppercase(key);
 
-    if (curTitle->prev == NULL) {
-      // Current title is the first in this list
-      // New title must be inserted at the beginning
-      curTitle->prev = title;
-      title->next = curTitle;
-      result->first = title;
-      break;
-    }
+  result->entries[result->total].key = key;
+  result->entries[result->total].order = result->total;
+  result->entries[result->total].target = title;
+  result->total++;
+  return 0;
+}
+
+// Moves all entries from src to the end of dst, keeping their discovery order
+int mergeScanResult(ScanResult *dst, ScanResult *src) {
+  if (dst->total + src->total > dst->capacity) {
+    ScanEntry *entries = realloc(dst->entries, sizeof(ScanEntry) * (dst->total + src->total));
+    if (entries == NULL)
+      return -ENOMEM;
+
+    dst->entries = entries;
+    dst->capacity = dst->total + src->total;
+  }
+
+  for (int i = 0; i < src->total; i++) {
+    dst->entries[dst->total] = src->entries[i];
+    dst->entries[dst->total].order = dst->total;
+    dst->total++;
+  }
+
+  // Targets and keys are now owned by dst
+  arenaMerge(&dst->arena, &src->arena);
+  arenaMerge(&dst->keyArena, &src->keyArena);
+  free(src->entries);
+  src->entries = NULL;
+  src->total = 0;
+  src->capacity = 0;
+  return 0;
+}
+
+// Frees all targets and memory used by the scan result
+void freeScanResult(ScanResult *result) {
+  arenaFree(&result->arena);
+  arenaFree(&result->keyArena);
+  free(result->entries);
+  result->entries = NULL;
+  result->total = 0;
+  result->capacity = 0;
+}
+
+// Compares two scan entries by collation key, falling back to discovery order
+int compareScanEntries(const void *a, const void *b) {
+  const ScanEntry *entryA = a;
+  const ScanEntry *entryB = b;
+
+  int res = strcmp(entryA->key, entryB->key);
+  if (res)
+    return res;
+  return entryA->order - entryB->order;
+}
+
+// Sorts scan result alphabetically and links targets into TargetList.
+// Moves targets into TargetList arena and frees memory used by the scan result.
+void buildTargetList(ScanResult *scan, TargetList *result) {
+  if (scan->total > 1)
+    qsort(scan->entries, scan->total, sizeof(ScanEntry), compareScanEntries);
+
+  Target *prev = NULL;
+  for (int i = 0; i < scan->total; i++) {
+    Target *title = scan->entries[i].target;
 
-    // Keep traversing the list
-    curTitle = curTitle->prev;
+    title->prev = prev;
+    title->next = NULL;
+    if (prev != NULL)
+      prev->next = title;
+    else
+      result->first = title;
+    prev = title;
   }
-  free(curUppercase);
+  result->last = prev;
+  result->total = scan->total;
+  arenaMerge(&result->arena, &scan->arena);
+
+  free(scan->entries);
+  arenaFree(&scan->keyArena);
+  scan->entries = NULL;
+  scan->total = 0;
+  scan->capacity = 0;
 }
 
-// Fills in title ID for every entry in the list
+// Fills in title IDs from the title ID cache and starts the background resolver
+// for titles that are missing from the cache.
+// Saves the target list snapshot if all title IDs are known
 void processTitleID(TargetList *result) {
-  if (result->total == 0)
+  int pending = loadCachedTitleIDs(result);
+  if (pending == 0) {
+    storeTargetListSnapshot(result);
     return;
+  }
+
+  logString("%d titles are missing from title ID cache\n", pending);
+  startTitleIDResolution(result, pending);
+}
 
+// Fills in title IDs from the title ID cache and returns the number of targets missing from the cache.
+// Updates the title ID cache if it contains titles that no longer exist or needs to be migrated.
+// Missing targets are added to the cache by the resolver once their title IDs are known
+int loadCachedTitleIDs(TargetList *result) {
   // Load title cache
   TitleIDCache *cache = malloc(sizeof(TitleIDCache));
   int isCacheUpdateNeeded = 0;
@@ -216,91 +743,389 @@ void processTitleID(TargetList *result) {
     logString("Failed to load title ID cache, all ISOs will be rescanned\n");
     free(cache);
     cache = NULL;
-  } else if (cache->total != result->total) {
-    // Set flag if number of entries is different
+  } else if (cache->version != TITLE_ID_CACHE_VERSION) {
+    // Set flag if cache needs to be migrated to the current version
     isCacheUpdateNeeded = 1;
   }
 
-  // For every entry in target list, try to get title ID from cache
-  // If cache doesn't have title ID for the path,
-  // get it from ISO
+  // For every entry in target list, try to get title ID from cache.
+  // Titles that are missing from the cache are left pending and resolved in the background
   int cacheMisses = 0;
   char *titleID = NULL;
   Target *curTarget = result->first;
   while (curTarget != NULL) {
-    // Try to get title ID from cache
-    if (cache != NULL) {
-      titleID = getCachedTitleID(curTarget->fullPath, cache);
-    }
+    if (cache != NULL)
+      titleID = getCachedTitleID(curTarget->fullPath, curTarget->size, cache);
 
-    if (titleID != NULL) {
-      curTarget->id = strdup(titleID);
-    } else { // Get title ID from ISO
+    if (titleID != NULL)
+      curTarget->id = (titleID[0] == '\0') ? invalidTitleID : arenaStrdup(&result->arena, titleID);
+
+    if (curTarget->id == NULL) {
       cacheMisses++;
       printf("Cache miss for %s\n", curTarget->fullPath);
-      curTarget->id = getTitleID(curTarget->fullPath);
-      if (curTarget->id == NULL) {
-        printf("WARN: Removing '%s' from target list\n", curTarget->name);
-        curTarget = freeTarget(curTarget);
-        result->total -= 1;
-      }
     }
-
     curTarget = curTarget->next;
   }
+  if (cache != NULL) {
+    printf("Title ID cache lookups: %d hits, %d misses (%d stale), %d probes\n", cache->hits, cache->misses, cache->stale,
+           cache->probes);
+    // Set flag if some cached titles no longer exist
+    if (cache->hits != cache->total)
+      isCacheUpdateNeeded = 1;
+  }
   freeTitleCache(cache);
 
-  if ((cacheMisses > 0) || (isCacheUpdateNeeded)) {
+  if (isCacheUpdateNeeded) {
     logString("Updating title ID cache\n");
-    if (storeTitleIDCache(result)) {
+    if (storeTitleIDCache(result))
       logString("Failed to save title ID cache\n");
+  }
+  return cacheMisses;
+}
+
+// Starts resolving pending title IDs in the background
+static void startTitleIDResolution(TargetList *list, int pending) {
+  memset(&resolver, 0, sizeof(TitleIDResolver));
+  resolver.list = list;
+  resolver.pending = pending;
+  resolver.threadID = -1;
+  if (startTitleIDResolver()) {
+    // Fall back to resolving title IDs in the calling thread
+    resolveTitleIDs();
+  }
+}
+
+// Creates and starts the title ID resolver thread.
+// The thread runs with higher priority than the calling thread: it spends most of the time waiting for I/O,
+// so the UI gets the CPU whenever the resolver is blocked.
+static int startTitleIDResolver() {
+  ee_thread_status_t threadStatus;
+  int priority = 0;
+  if ((ReferThreadStatus(GetThreadId(), &threadStatus) >= 0) && (threadStatus.current_priority > 0))
+    priority = threadStatus.current_priority - 1;
+
+  ee_sema_t sema = {.init_count = 0, .max_count = 1, .option = 0};
+  if ((resolver.doneSema = CreateSema(&sema)) < 0)
+    return resolver.doneSema;
+
+  resolver.stack = memalign(16, RESOLVER_THREAD_STACK_SIZE);
+  if (resolver.stack == NULL) {
+    DeleteSema(resolver.doneSema);
+    return -ENOMEM;
+  }
+
+  ee_thread_t thread = {
+      .func = titleIDResolverThread,
+      .stack = resolver.stack,
+      .stack_size = RESOLVER_THREAD_STACK_SIZE,
+      .gp_reg = &_gp,
+      .initial_priority = priority,
+      .attr = 0,
+      .option = 0,
+  };
+  int threadID = CreateThread(&thread);
+  if (threadID < 0) {
+    printf("ERROR: Failed to create title ID resolver thread: %d\n", threadID);
+    DeleteSema(resolver.doneSema);
+    free(resolver.stack);
+    resolver.stack = NULL;
+    return threadID;
+  }
+
+  resolver.threadID = threadID;
+  StartThread(threadID, NULL);
+  return 0;
+}
+
+// Resolves pending title IDs and signals resolver semaphore once done
+static void titleIDResolverThread(void *arg) {
+  resolveTitleIDs();
+  SignalSema(resolver.doneSema);
+  ExitThread();
+}
+
+// Stops the resolver thread, waiting for the title that is currently being processed
+static void stopTitleIDResolver() {
+  if (resolver.threadID < 0)
+    return;
+
+  resolver.isStopRequested = 1;
+  WaitSema(resolver.doneSema);
+  TerminateThread(resolver.threadID);
+  DeleteThread(resolver.threadID);
+  DeleteSema(resolver.doneSema);
+  free(resolver.stack);
+  resolver.stack = NULL;
+  resolver.threadID = -1;
+}
+
+// Returns index of the next pending target, prioritizing targets around the focused title.
+// Returns -1 if there are no pending targets left.
+static int getNextPendingTarget() {
+  TargetList *list = resolver.list;
+  int focusIdx = resolver.focusIdx;
+  for (int offset = 0; offset <= RESOLVER_FOCUS_WINDOW; offset++) {
+    if ((focusIdx + offset < list->total) && (list->targets[focusIdx + offset]->id == NULL))
+      return focusIdx + offset;
+    if ((offset > 0) && (focusIdx - offset >= 0) && (list->targets[focusIdx - offset]->id == NULL))
+      return focusIdx - offset;
+  }
+
+  // Continue from the first pending target in the list
+  while ((resolver.cursor < list->total) && (list->targets[resolver.cursor]->id != NULL))
+    resolver.cursor++;
+
+  if (resolver.cursor == list->total)
+    return -1;
+  return resolver.cursor;
+}
+
+// Gets title IDs for all pending targets from ISOs and updates title ID cache
+static void resolveTitleIDs() {
+  TargetList *list = resolver.list;
+  Target *target;
+  char *titleID;
+  char *id;
+  int idx;
+  int resolved = 0;
+  clock_t start = clock();
+  while (!resolver.isStopRequested && ((idx = getNextPendingTarget()) >= 0)) {
+    target = list->targets[idx];
+
+    id = invalidTitleID;
+    if ((titleID = getTitleID(target->fullPath)) != NULL) {
+      if ((id = arenaStrdup(&list->arena, titleID)) == NULL)
+        id = invalidTitleID;
+      free(titleID);
     }
+    if (id == invalidTitleID)
+      printf("WARN: Failed to get title ID for '%s'\n", target->name);
+
+    // Publish the title ID only after the string has been fully written
+    target->id = id;
+    resolver.pending--;
+    resolved++;
   }
+  printf("Resolved %d title IDs in %d ms, %d left\n", resolved, (int)((clock() - start) * 1000 / CLOCKS_PER_SEC), resolver.pending);
+
+  // Targets without a valid title ID are cached too, so they are not read again on the next launch
+  if (resolved > 0) {
+    printf("Updating title ID cache\n");
+    if (storeTitleIDCache(list))
+      printf("Failed to save title ID cache\n");
+  }
+  if (resolver.pending == 0)
+    storeTargetListSnapshot(list);
+  resolver.isDone = 1;
 }
 
-// Completely frees Target and returns pointer to a previous argument in the list
-Target *freeTarget(Target *target) {
-  Target *prev = NULL;
-  free(target->fullPath);
-  free(target->name);
-  free(target->id);
-  if (target->prev != NULL) {
-    prev = target->prev;
-    if (target->next != NULL) {
-      prev->next = target->next;
-      target->next->prev = prev;
+// Sets the index of the title currently selected in the UI.
+// Title IDs of targets around this index are resolved first.
+void setTitleIDFocus(TargetList *list, int idx) {
+  if ((resolver.list == list) && (idx >= 0) && (idx < list->total))
+    resolver.focusIdx = idx;
+}
+
+// Waits until the title ID for the target is resolved.
+// Returns 0 if target has a valid title ID
+int waitForTitleID(TargetList *list, Target *target) {
+  if (resolver.list == list) {
+    setTitleIDFocus(list, target->idx);
+    while ((target->id == NULL) && !resolver.isDone)
+      DelayThread(RESOLVER_POLL_INTERVAL);
+  }
+
+  if ((target->id == NULL) || (target->id[0] == '\0'))
+    return -ENOENT;
+  return 0;
+}
+
+// Creates and starts the thread that validates the snapshot list against the devices.
+// The thread runs with lower priority than the calling thread, so it only gets the CPU while the UI thread is blocked.
+// This relies on the UI loop sleeping until vsync when there's nothing to redraw
+static int startTargetListValidator(TargetList *list) {
+  ee_thread_status_t threadStatus;
+  int priority = 0;
+  if (ReferThreadStatus(GetThreadId(), &threadStatus) >= 0)
+    priority = threadStatus.current_priority + 1;
+
+  memset(&validator, 0, sizeof(TargetListValidator));
+  validator.threadID = -1;
+  ee_sema_t sema = {.init_count = 0, .max_count = 1, .option = 0};
+  if ((validator.doneSema = CreateSema(&sema)) < 0)
+    return validator.doneSema;
+
+  validator.stack = memalign(16, VALIDATOR_THREAD_STACK_SIZE);
+  if (validator.stack == NULL) {
+    DeleteSema(validator.doneSema);
+    return -ENOMEM;
+  }
+
+  ee_thread_t thread = {
+      .func = targetListValidatorThread,
+      .stack = validator.stack,
+      .stack_size = VALIDATOR_THREAD_STACK_SIZE,
+      .gp_reg = &_gp,
+      .initial_priority = priority,
+      .attr = 0,
+      .option = 0,
+  };
+  int threadID = CreateThread(&thread);
+  if (threadID < 0) {
+    printf("ERROR: Failed to create target list validator thread: %d\n", threadID);
+    DeleteSema(validator.doneSema);
+    free(validator.stack);
+    validator.stack = NULL;
+    return threadID;
+  }
+
+  validator.list = list;
+  validator.threadID = threadID;
+  StartThread(threadID, NULL);
+  return 0;
+}
+
+// Scans the devices and compares the result with the snapshot list.
+// Signals validator semaphore once done
+static void targetListValidatorThread(void *arg) {
+  clock_t start = clock();
+  TargetList *result = scanTargets(0);
+  if ((result != NULL) && !isScanCancelled) {
+    validator.pending = loadCachedTitleIDs(result);
+    if (!reconcileTargetList(validator.list, result)) {
+      freeTargetList(result);
+      result = NULL;
+    } else if ((validator.pending == 0) && !isScanCancelled) {
+      storeTargetListSnapshot(result);
     }
+  } else if (result != NULL) {
+    freeTargetList(result);
+    result = NULL;
   }
-  free(target);
-  return prev;
+  validator.result = result;
+  printf("Validated target list snapshot in %d ms: %s\n", (int)((clock() - start) * 1000 / CLOCKS_PER_SEC),
+         (isScanCancelled) ? "cancelled" : ((result != NULL) ? "list has changed" : "no changes"));
+
+  validator.isDone = 1;
+  SignalSema(validator.doneSema);
+  ExitThread();
+}
+
+// Waits for the validator thread to finish.
+// If cancel is set, the validator stops after the directory or the file write it's currently processing
+static void stopTargetListValidator(int cancel) {
+  if (validator.threadID < 0)
+    return;
+
+  isScanCancelled = cancel;
+  WaitSema(validator.doneSema);
+  isScanCancelled = 0;
+  TerminateThread(validator.threadID);
+  DeleteThread(validator.threadID);
+  DeleteSema(validator.doneSema);
+  free(validator.stack);
+  validator.stack = NULL;
+  validator.threadID = -1;
+}
+
+// Copies title IDs missing from result from snapshot targets with the same path and size.
+// Returns 1 if result is different from the snapshot or 0 if it's the same or the validation has been cancelled
+static int reconcileTargetList(TargetList *snapshot, TargetList *result) {
+  int isChanged = (snapshot->total != result->total);
+  for (int i = 0; i < result->total; i++) {
+    if (isScanCancelled)
+      return 0;
+
+    Target *target = result->targets[i];
+    Target *cached = (i < snapshot->total) ? snapshot->targets[i] : NULL;
+    if ((cached == NULL) || (cached->size != target->size) || (cached->deviceType != target->deviceType) ||
+        strcmp(cached->fullPath, target->fullPath) || strcmp(cached->name, target->name)) {
+      isChanged = 1;
+      continue;
+    }
+
+    if (target->id == NULL) {
+      if ((target->id = arenaStrdup(&result->arena, cached->id)) == NULL)
+        continue;
+      validator.pending--;
+    }
+    if (strcmp(cached->id, target->id))
+      isChanged = 1;
+  }
+  return isChanged;
+}
+
+// Replaces list contents with the list built by the background validator once it's done.
+// selectedIdx is updated to point to the same title in the new list.
+// Returns 1 if the list has been replaced. All pointers to list targets are invalid in this case
+int updateTargetList(TargetList *list, int *selectedIdx) {
+  if ((validator.list != list) || !validator.isDone)
+    return 0;
+
+  stopTargetListValidator(0);
+  validator.list = NULL;
+  TargetList *result = validator.result;
+  validator.result = NULL;
+  if (result == NULL)
+    return 0;
+
+  // Find the selected title in the new list
+  Target *selected = getTargetByIdx(list, *selectedIdx);
+  int newIdx = 0;
+  for (Target *target = result->first; (selected != NULL) && (target != NULL); target = target->next) {
+    if (!strcmp(target->fullPath, selected->fullPath)) {
+      newIdx = target->idx;
+      break;
+    }
+  }
+
+  // Move new list contents into list and free the old targets
+  Arena arena = list->arena;
+  *list = *result;
+  arenaFree(&arena);
+  free(result);
+  *selectedIdx = newIdx;
+  logString("Target list has been updated, %d titles\n", list->total);
+
+  if (validator.pending > 0)
+    startTitleIDResolution(list, validator.pending);
+  return 1;
 }
 
 // Completely frees TargetList. Passed pointer will not be valid after this function executes
 void freeTargetList(TargetList *result) {
-  Target *target = result->last;
-  while (target != NULL) {
-    target = freeTarget(target);
+  if (resolver.list == result) {
+    stopTitleIDResolver();
+    resolver.list = NULL;
   }
+  if (validator.list == result) {
+    // Cancel the validation and discard its result
+    stopTargetListValidator(1);
+    validator.list = NULL;
+    if (validator.result != NULL) {
+      freeTargetList(validator.result);
+      validator.result = NULL;
+    }
+  }
+#ifdef DEBUG
+  printf("Target list arena: %d bytes used, %d bytes allocated in %d blocks\n", (int)result->arena.used, (int)result->arena.allocated,
+         result->arena.blockCount);
+#endif
+  // All targets are allocated from the arena
+  arenaFree(&result->arena);
+  result->targets = NULL;
   result->first = NULL;
   result->last = NULL;
   result->total = 0;
   free(result);
 }
 
-// Finds target with given index in the list and returns a pointer to it
+// Returns a pointer to target with given index or NULL if index is out of bounds
 Target *getTargetByIdx(TargetList *targets, int idx) {
-  Target *current = targets->first;
-  while (1) {
-    if (current->idx == idx) {
-      return current;
-    }
+  if ((idx < 0) || (idx >= targets->total))
+    return NULL;
 
-    if (current->next == NULL)
-      break;
-
-    current = current->next;
-  }
-  return NULL;
+  return targets->targets[idx];
 }
 
 // Makes and returns a deep copy of src without prev/next pointers.
@@ -312,6 +1137,7 @@ Target *copyTarget(Target *src) {
   copy->name = strdup(src->name);
   copy->id = strdup(src->id);
   copy->deviceType = src->deviceType;
+  copy->size = src->size;
 
   return copy;
 }
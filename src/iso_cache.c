@@ -4,254 +4,1027 @@
 #include "iso.h"
 #include "devices.h"
 #include "options.h"
+#include <fcntl.h>
 #include <malloc.h>
 #include <ps2sdkapi.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <zlib.h>
 
 #define CACHE_MAGIC "NIDC"
-#define CACHE_VERSION 2
+// Cache version that doesn't store ISO sizes and can be migrated to TITLE_ID_CACHE_VERSION
+#define CACHE_VERSION_LEGACY 2
 
 const char titleIDCacheFile[] = "/cache.bin";
 #define MAX_CACHE_PATH_LEN MASS_PLACEHOLDER_LEN + BASE_CONFIG_PATH_LEN + (sizeof(titleIDCacheFile) / sizeof(char))
 
-// Structs used to read and write cache file contents
+static int serializeTitleIDCache(Target **targets, int total, char *buf);
+static int writeTitleIDCache(int device, char *buf, int size);
+static int parseTitleIDCache(TitleIDCache *cache, char *buf, int fileSize, int device);
+static int parseLegacyTitleIDCache(TitleIDCache *cache, char *buf, int fileSize, int total);
+static int compareTargetPaths(const void *a, const void *b);
+static char *getPathWithoutMountpoint(char *fullPath);
+static uint32_t hashPath(const char *path);
+static int getCacheIndexSize(int total);
+static void buildCacheIndex(TitleIDCache *cache);
+
+// Cache file header.
+// All fields are fixed-width and little-endian.
+// Header is followed by the entry table sorted by path and the string table
+// that contains null-terminated ISO paths without the mountpoint.
 typedef struct {
-  char titleID[12];
-  size_t pathLength; // Includes null-terminator
-} CacheEntryHeader;
+  char magic[4];       // Must be always equal to CACHE_MAGIC
+  uint8_t version;     // Cache version
+  uint8_t reserved[3]; //
+  uint32_t total;      // Total number of entries
+  uint32_t checksum;   // CRC32 of the entry and string tables
+} CacheHeader;
 
+// Cache file entry
 typedef struct {
-  char magic[4];   // Must be always equal to CACHE_MAGIC
-  uint8_t version; // Cache version
-  int total;       // Total number of elements in cache file
-} CacheMetadata;
+  char titleID[12];    // Null-terminated title ID. Empty if the ISO doesn't have a valid title ID
+  uint32_t pathOffset; // Offset of ISO path in the string table
+  uint64_t size;       // ISO size, used to detect replaced files
+} CacheRecord;
 
-// Saves TargetList into title ID cache on every storage device
+// Version 2 cache file header and entry header as written by the EE
+typedef struct {
+  char magic[4];
+  uint8_t version;
+  uint32_t total;
+} LegacyCacheHeader;
+
+typedef struct {
+  char titleID[12];
+  uint32_t pathLength; // Includes null-terminator
+} LegacyCacheEntryHeader;
+
+// Cache files stored on each device, used to skip writing files that haven't changed
+static struct {
+  int isPresent;      // Set if the device has a cache file
+  CacheHeader header; // Header of the stored file. Zeroed if the file is not valid
+} storedCaches[MAX_MASS_DEVICES];
+
+// Saves TargetList into title ID cache.
+// Every device stores only its own titles. Files are serialized in memory
+// and only written with a single write if their contents have changed
 int storeTitleIDCache(TargetList *list) {
   if (list->total == 0) {
     return 0;
   }
 
-  // Get total number of valid cache entries
-  int total = 0;
-  Target *curTitle = list->first;
-  while (curTitle != NULL) {
-    if (strlen(curTitle->id) == 11) {
-      total++;
-    }
-    curTitle = curTitle->next;
+  // Collect valid cache entries
+  Target **targets = malloc(sizeof(Target *) * list->total);
+  if (targets == NULL) {
+    printf("ERROR: Can't allocate enough memory\n");
+    return -ENOMEM;
   }
-  if (total == 0) {
-    printf("WARN: No valid cache entries found\n");
-    return 0;
+  int total = 0;
+  size_t maxFileSize = sizeof(CacheHeader);
+  for (Target *curTitle = list->first; curTitle != NULL; curTitle = curTitle->next) {
+    // Ignore pending entries and title IDs that don't fit into the record.
+    // Empty title IDs are kept so ISOs without a valid title ID are not read again
+    if ((curTitle->id == NULL) || ((curTitle->id[0] != '\0') && (strlen(curTitle->id) != 11)))
+      continue;
+
+    targets[total++] = curTitle;
+    maxFileSize += sizeof(CacheRecord) + strlen(getPathWithoutMountpoint(curTitle->fullPath)) + 1;
   }
+  // Sort entries by device and path so titles of each device are adjacent
+  // and unchanged lists always produce the same file
+  qsort(targets, total, sizeof(Target *), compareTargetPaths);
 
-  // Prepare paths and header
-  char cachePath[MAX_CACHE_PATH_LEN];
-  char dirPath[MAX_CACHE_PATH_LEN];
-  buildConfigFilePath(dirPath, MASS_PLACEHOLDER, NULL);
-  buildConfigFilePath(cachePath, MASS_PLACEHOLDER, titleIDCacheFile);
+  // Allocate buffer large enough for any device
+  char *buf = malloc(maxFileSize);
+  if (buf == NULL) {
+    printf("ERROR: Can't allocate enough memory\n");
+    free(targets);
+    return -ENOMEM;
+  }
 
-  CacheEntryHeader header;
-  CacheMetadata meta = {.magic = CACHE_MAGIC, .version = CACHE_VERSION, .total = total};
+  int res = 0;
+  int first = 0;
   for (int i = 0; i < MAX_MASS_DEVICES; i++) {
-    if (deviceModeMap[i].mode  == MODE_ALL) {
+    if (deviceModeMap[i].mode == MODE_ALL) {
       break;
     }
-    cachePath[4] = i + '0';
-    dirPath[4] = i + '0';
-
-    // Get path to config directory and make sure it exists
-    struct stat st;
-    if (stat(dirPath, &st) == -1) {
-      printf("Creating config directory: %s\n", dirPath);
-      if (mkdir(dirPath, 0777)) {
-        printf("ERROR: Failed to create directory\n");
-        continue;
-      }
-    }
 
-    // Open cache file for writing
-    FILE *file = fopen(cachePath, "wb");
-    if (file == NULL) {
-      printf("ERROR: Failed to open cache file for writing\n");
+    // Get titles located on the device
+    int count = 0;
+    while ((first + count < total) && (targets[first + count]->fullPath[4] == i + '0'))
+      count++;
+
+    int size = serializeTitleIDCache(&targets[first], count, buf);
+    first += count;
+    // Skip devices without titles and devices where cache contents are the same
+    if ((!count && !storedCaches[i].isPresent) ||
+        (storedCaches[i].isPresent && !memcmp(buf, &storedCaches[i].header, sizeof(CacheHeader))))
       continue;
-    }
 
-    int result;
-    // Write cache file header
-    result = fwrite(&meta, sizeof(CacheMetadata), 1, file);
-    if (!result) {
-      printf("ERROR: Failed to write metadata: %d\n", errno);
-      fclose(file);
-      remove(cachePath);
-      return result;
+    printf("Updating title ID cache on mass%d: with %d titles\n", i, count);
+    if (writeTitleIDCache(i, buf, size)) {
+      res = -EIO;
+      continue;
     }
+    storedCaches[i].isPresent = 1;
+    memcpy(&storedCaches[i].header, buf, sizeof(CacheHeader));
+  }
+  free(targets);
+  free(buf);
+  return res;
+}
 
-    // Write each entry
-    curTitle = list->first;
-    while (curTitle != NULL) {
-      if (strlen(curTitle->id) < 11) {
-        // Ignore empty entries
-        curTitle = curTitle->next;
-        continue;
-      }
+// Serializes total targets into buf and returns the file size
+static int serializeTitleIDCache(Target **targets, int total, char *buf) {
+  CacheHeader *header = (CacheHeader *)buf;
+  CacheRecord *records = (CacheRecord *)&buf[sizeof(CacheHeader)];
+  char *stringTable = (char *)&records[total];
+  uint32_t pathOffset = 0;
+  for (int i = 0; i < total; i++) {
+    char *path = getPathWithoutMountpoint(targets[i]->fullPath);
+    int pathLength = strlen(path) + 1;
 
-      int mountpointLen = 5;
-      if (curTitle->fullPath[5] == ':') {
-        mountpointLen = 6;
-      }
+    memset(&records[i], 0, sizeof(CacheRecord));
+    memcpy(records[i].titleID, targets[i]->id, strlen(targets[i]->id));
+    records[i].pathOffset = pathOffset;
+    records[i].size = targets[i]->size;
+    memcpy(&stringTable[pathOffset], path, pathLength);
+    pathOffset += pathLength;
+  }
 
-      // Write entry header
-      memcpy(header.titleID, curTitle->id, sizeof(header.titleID));
-      header.titleID[11] = '\0';
-      header.pathLength = strlen(curTitle->fullPath) - mountpointLen + 1;
-      result = fwrite(&header, sizeof(CacheEntryHeader), 1, file);
-      if (!result) {
-        printf("ERROR: %s: Failed to write header: %d\n", curTitle->name, errno);
-        fclose(file);
-        remove(cachePath);
-        return result;
-      }
-      // Write full ISO path without the mountpoint
-      result = fwrite(curTitle->fullPath + mountpointLen, header.pathLength, 1, file);
-      if (!result) {
-        printf("ERROR: %s: Failed to write full path: %d\n", curTitle->name, errno);
-        fclose(file);
-        remove(cachePath);
-        return result;
-      }
-      curTitle = curTitle->next;
+  int size = sizeof(CacheHeader) + sizeof(CacheRecord) * total + pathOffset;
+  memset(header, 0, sizeof(CacheHeader));
+  memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+  header->version = TITLE_ID_CACHE_VERSION;
+  header->total = total;
+  header->checksum = crc32(0, (unsigned char *)records, size - sizeof(CacheHeader));
+  return size;
+}
+
+// Writes size bytes of serialized cache to the device
+static int writeTitleIDCache(int device, char *buf, int size) {
+  char cachePath[MAX_CACHE_PATH_LEN];
+  buildConfigFilePath(cachePath, MASS_PLACEHOLDER, NULL);
+  cachePath[4] = device + '0';
+
+  // Make sure config directory exists
+  struct stat st;
+  if (stat(cachePath, &st) == -1) {
+    printf("Creating config directory: %s\n", cachePath);
+    if (mkdir(cachePath, 0777)) {
+      printf("ERROR: Failed to create directory\n");
+      return -EIO;
     }
-    fclose(file);
   }
+  strcat(cachePath, titleIDCacheFile);
+
+  int fd = open(cachePath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    printf("ERROR: Failed to open cache file for writing\n");
+    return -EIO;
+  }
+  if (write(fd, buf, size) != size) {
+    printf("ERROR: Failed to write cache file: %d\n", errno);
+    close(fd);
+    remove(cachePath);
+    return -EIO;
+  }
+  close(fd);
   return 0;
 }
 
-// Loads title ID cache from storage into cache
+// Loads title ID cache from every storage device into cache.
+// Each file is read with a single read into a buffer that also holds the entry array and the hash index,
+// so cache entries point directly into the file contents.
+// Version 2 files are loaded without ISO sizes and must be rewritten by the caller
 int loadTitleIDCache(TitleIDCache *cache) {
-  cache->total = 0;
-  cache->lastMatchedIdx = 0;
+  memset(cache, 0, sizeof(TitleIDCache));
+  cache->version = TITLE_ID_CACHE_VERSION;
 
-  // Open cache file for reading
   char cachePath[MAX_CACHE_PATH_LEN];
   buildConfigFilePath(cachePath, MASS_PLACEHOLDER, titleIDCacheFile);
 
-  FILE *file;
-  // Load the first found cache file
+  // Open cache files and get total size.
+  // File contents are aligned to 8 bytes
+  int fds[MAX_MASS_DEVICES];
+  int fileSizes[MAX_MASS_DEVICES];
+  int dataSize = 0;
   for (int i = 0; i < MAX_MASS_DEVICES; i++) {
-    if (deviceModeMap[i].mode  == MODE_ALL) {
-      printf("ERROR: failed to open cache file\n");
-      return -ENOENT;
-    }
+    fds[i] = -1;
+    fileSizes[i] = 0;
+    if (deviceModeMap[i].mode == MODE_ALL)
+      continue;
     cachePath[4] = i + '0';
 
-    file = fopen(cachePath, "rb");
-    if (file != NULL)
-      break;
+    memset(&storedCaches[i], 0, sizeof(storedCaches[i]));
+    if ((fds[i] = open(cachePath, O_RDONLY)) < 0)
+      continue;
+
+    storedCaches[i].isPresent = 1;
+    fileSizes[i] = lseek(fds[i], 0, SEEK_END);
+    lseek(fds[i], 0, SEEK_SET);
+    dataSize += (fileSizes[i] + 7) & ~7;
+  }
+  if (dataSize == 0) {
+    for (int i = 0; i < MAX_MASS_DEVICES; i++) {
+      if (fds[i] >= 0)
+        close(fds[i]);
+    }
+    printf("ERROR: failed to open cache file\n");
+    return -ENOENT;
+  }
+
+  char *data = malloc(dataSize);
+  if (data == NULL) {
+    for (int i = 0; i < MAX_MASS_DEVICES; i++) {
+      if (fds[i] >= 0)
+        close(fds[i]);
+    }
+    printf("ERROR: Can't allocate enough memory\n");
+    return -ENOMEM;
   }
 
-  int result;
+  // Read every file and make sure the header is valid.
+  // Every entry takes at least an entry header and a null-terminator
+  CacheHeader header;
+  int fileOffsets[MAX_MASS_DEVICES];
+  int offset = 0;
+  int maxTotal = 0;
+  for (int i = 0; i < MAX_MASS_DEVICES; i++) {
+    if (fds[i] < 0)
+      continue;
 
-  // Read cache file header
-  CacheMetadata meta;
-  result = fread(&meta, sizeof(CacheMetadata), 1, file);
-  if (!result) {
-    printf("ERROR: Failed to read cache metadata\n");
-    fclose(file);
-    return result;
+    int res = read(fds[i], &data[offset], fileSizes[i]);
+    close(fds[i]);
+    if ((fileSizes[i] < (int)sizeof(CacheHeader)) || (res != fileSizes[i])) {
+      printf("ERROR: mass%d: Failed to read cache file\n", i);
+      fileSizes[i] = 0;
+      continue;
+    }
+
+    int total = 0;
+    memcpy(&header, &data[offset], sizeof(CacheHeader));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic))) {
+      printf("ERROR: mass%d: Cache magic doesn't match, refusing to load\n", i);
+      fileSizes[i] = 0;
+      continue;
+    } else if (header.version == TITLE_ID_CACHE_VERSION) {
+      total = (fileSizes[i] - sizeof(CacheHeader)) / (sizeof(CacheRecord) + 1);
+    } else if (header.version == CACHE_VERSION_LEGACY) {
+      // Total is located at the same offset in both versions
+      total = (fileSizes[i] - sizeof(LegacyCacheHeader)) / (sizeof(LegacyCacheEntryHeader) + 1);
+    } else {
+      printf("ERROR: mass%d: Unsupported cache version %d\n", i, header.version);
+      fileSizes[i] = 0;
+      continue;
+    }
+    if (header.total > total) {
+      printf("ERROR: mass%d: Invalid cache entry count %u\n", i, header.total);
+      fileSizes[i] = 0;
+      continue;
+    }
+
+    fileOffsets[i] = offset;
+    offset += (fileSizes[i] + 7) & ~7;
+    maxTotal += header.total;
   }
 
-  // Make sure header is valid
-  if (!strcmp(meta.magic, CACHE_MAGIC)) {
-    printf("ERROR: Cache magic doesn't match, refusing to load\n");
-    fclose(file);
+  // Grow the buffer to fit entry array and hash index after the file contents
+  int indexSize = getCacheIndexSize(maxTotal);
+  int entriesOffset = offset;
+  int indexOffset = entriesOffset + sizeof(CacheEntry) * maxTotal;
+  char *buf = realloc(data, indexOffset + sizeof(int) * indexSize);
+  if (buf == NULL) {
+    printf("ERROR: Can't allocate enough memory\n");
+    free(data);
+    return -ENOMEM;
+  }
+  cache->data = buf;
+  cache->entries = (CacheEntry *)&buf[entriesOffset];
+  cache->index = (int *)&buf[indexOffset];
+  cache->indexSize = indexSize;
+
+  // Parse entries in place
+  int loaded = 0;
+  for (int i = 0; i < MAX_MASS_DEVICES; i++) {
+    if (fileSizes[i] == 0)
+      continue;
+
+    char *fileData = &buf[fileOffsets[i]];
+    if (((CacheHeader *)fileData)->version == CACHE_VERSION_LEGACY) {
+      // Legacy files contain titles from all devices and need to be replaced
+      parseLegacyTitleIDCache(cache, fileData, fileSizes[i], ((LegacyCacheHeader *)fileData)->total);
+      cache->version = CACHE_VERSION_LEGACY;
+    } else if (parseTitleIDCache(cache, fileData, fileSizes[i], i)) {
+      continue;
+    } else {
+      memcpy(&storedCaches[i].header, fileData, sizeof(CacheHeader));
+    }
+    loaded++;
+  }
+  if (!loaded) {
+    free(buf);
+    memset(cache, 0, sizeof(TitleIDCache));
     return -EINVAL;
   }
-  if (meta.version != CACHE_VERSION) {
-    printf("ERROR: Unsupported cache version %d\n", meta.version);
-    fclose(file);
+
+  buildCacheIndex(cache);
+  return 0;
+}
+
+// Validates the current cache version contents and appends file entries to cache
+static int parseTitleIDCache(TitleIDCache *cache, char *buf, int fileSize, int device) {
+  CacheHeader *header = (CacheHeader *)buf;
+  CacheRecord *records = (CacheRecord *)&buf[sizeof(CacheHeader)];
+  char *stringTable = (char *)&records[header->total];
+  uint32_t stringTableSize = &buf[fileSize] - stringTable;
+
+  if (crc32(0, (unsigned char *)records, fileSize - sizeof(CacheHeader)) != header->checksum) {
+    printf("ERROR: mass%d: Cache checksum doesn't match, refusing to load\n", device);
+    return -EINVAL;
+  }
+  // Make sure the last path is terminated so all path offsets point to valid strings
+  if ((header->total > 0) && ((stringTableSize == 0) || (stringTable[stringTableSize - 1] != '\0'))) {
+    printf("ERROR: mass%d: Cache string table is corrupted, refusing to load\n", device);
     return -EINVAL;
   }
+  for (int i = 0; i < header->total; i++) {
+    if (records[i].pathOffset >= stringTableSize) {
+      printf("ERROR: mass%d: Cache entry %d is corrupted, refusing to load\n", device, i);
+      return -EINVAL;
+    }
+  }
 
-  // Allocate memory for cache entries based on total entry count from header metadata
-  int readIndex = 0;
-  cache->entries = malloc((sizeof(CacheEntry) * meta.total));
-  if (cache->entries == NULL) {
-    printf("ERROR: Can't allocate enough memory\n");
-    fclose(file);
-    return -ENOMEM;
+  CacheEntry *entry = &cache->entries[cache->total];
+  for (int i = 0; i < header->total; i++, entry++) {
+    entry->titleID = records[i].titleID;
+    entry->titleID[11] = '\0';
+    entry->fullPath = &stringTable[records[i].pathOffset];
+    entry->size = records[i].size;
+    entry->device = device;
   }
+  cache->total += header->total;
+  return 0;
+}
 
-  // Read each entry into cache
-  CacheEntryHeader header;
-  char pathBuf[PATH_MAX + 1];
-  while (!feof(file)) {
-    // Read cache entry header
-    pathBuf[0] = '\0';
-    result = fread(&header, sizeof(CacheEntryHeader), 1, file);
-    if (result != 1) {
-      if (!feof(file))
-        printf("WARN: Read less than expected, title ID cache might be incomplete\n");
+// Appends entries from version 2 cache contents to cache.
+// ISO sizes and devices are not available, so entries are matched by path only
+static int parseLegacyTitleIDCache(TitleIDCache *cache, char *buf, int fileSize, int total) {
+  printf("Migrating title ID cache from version %d\n", CACHE_VERSION_LEGACY);
+
+  LegacyCacheEntryHeader header;
+  int offset = sizeof(LegacyCacheHeader);
+  int readIndex = 0;
+  while (readIndex < total) {
+    if (offset + (int)sizeof(LegacyCacheEntryHeader) > fileSize) {
+      printf("WARN: Read less than expected, title ID cache might be incomplete\n");
       break;
     }
-    // Read ISO path
-    result = fread(&pathBuf, header.pathLength, 1, file);
-    if (result != 1) {
+    // Get cache entry header
+    memcpy(&header, &buf[offset], sizeof(LegacyCacheEntryHeader));
+    CacheEntry *entry = &cache->entries[cache->total + readIndex];
+    entry->titleID = &buf[offset + offsetof(LegacyCacheEntryHeader, titleID)];
+    entry->titleID[11] = '\0';
+    entry->size = 0;
+    entry->device = -1;
+    offset += sizeof(LegacyCacheEntryHeader);
+
+    // Get ISO path
+    if ((header.pathLength == 0) || (header.pathLength > fileSize - offset)) {
       printf("WARN: Read less than expected, title ID cache might be incomplete\n");
       break;
     }
-    pathBuf[header.pathLength] = '\0';
-
-    // Store entry in cache
-    CacheEntry entry;
-    memcpy(entry.titleID, header.titleID, sizeof(entry.titleID));
-    header.titleID[11] = '\0';
-    entry.fullPath = strdup(pathBuf);
-    cache->entries[readIndex] = entry;
+    entry->fullPath = &buf[offset];
+    buf[offset + header.pathLength - 1] = '\0';
+    offset += header.pathLength;
     readIndex++;
   }
-  fclose(file);
+  cache->total += readIndex;
+  return 0;
+}
 
-  // Free unused memory
-  if (readIndex != meta.total)
-    cache->entries = realloc(cache->entries, sizeof(CacheEntry) * readIndex);
+// Compares full target paths.
+// Since device numbers only have one digit, targets are sorted by device first
+static int compareTargetPaths(const void *a, const void *b) { return strcmp((*(Target **)a)->fullPath, (*(Target **)b)->fullPath); }
 
-  cache->total = readIndex;
-  return 0;
+// Returns a pointer to fullPath with the mountpoint skipped
+static char *getPathWithoutMountpoint(char *fullPath) {
+  if (fullPath[5] == ':')
+    return fullPath + 6;
+  return fullPath + 5;
 }
 
 // Returns a pointer to title ID or NULL if fullPath is not found in the cache
-char *getCachedTitleID(char *fullPath, TitleIDCache *cache) {
-  // This code takes advantage of all entries in the title list being sorted alphabetically.
-  // By starting from the index of the last matched entry, we can skip comparing fullPath with entries
-  // that have already been matched to a title ID, improving lookup speeds for very large lists.
+// or the cached ISO size doesn't match size
+char *getCachedTitleID(char *fullPath, uint64_t size, TitleIDCache *cache) {
+  char *path = getPathWithoutMountpoint(fullPath);
+  int device = fullPath[4] - '0';
 
-  int mountpointLen = 5;
-  if (fullPath[5] == ':') {
-    mountpointLen = 6;
-  }
+  if (cache->index != NULL) {
+    int mask = cache->indexSize - 1;
+    for (uint32_t slot = hashPath(path) & mask;; slot = (slot + 1) & mask) {
+      cache->probes++;
+      if (cache->index[slot] == 0)
+        break;
 
-  for (int i = cache->lastMatchedIdx; i < cache->total; i++) {
-    if (!strcmp(cache->entries[i].fullPath, fullPath + mountpointLen)) {
-      cache->lastMatchedIdx = i;
-      return cache->entries[i].titleID;
+      CacheEntry *entry = &cache->entries[cache->index[slot] - 1];
+      if (((entry->device == device) || (entry->device < 0)) && !strcmp(entry->fullPath, path)) {
+        // ISO has been replaced with a different file
+        if (entry->size && (entry->size != size)) {
+          cache->stale++;
+          break;
+        }
+        cache->hits++;
+        return entry->titleID;
+      }
     }
   }
+
+  cache->misses++;
   return NULL;
 }
 
+// Calculates FNV-1a hash of the path
+static uint32_t hashPath(const char *path) {
+  uint32_t hash = 2166136261u;
+  for (; *path != '\0'; path++) {
+    hash ^= (uint8_t)*path;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Returns the number of hash index slots for total entries.
+// The index is kept at most half full to keep probe sequences short.
+static int getCacheIndexSize(int total) {
+  int indexSize = 16;
+  while (indexSize < total * 2)
+    indexSize <<= 1;
+  return indexSize;
+}
+
+// Builds open-addressing hash index for all cache entries
+static void buildCacheIndex(TitleIDCache *cache) {
+  memset(cache->index, 0, sizeof(int) * cache->indexSize);
+
+  int mask = cache->indexSize - 1;
+  for (int i = 0; i < cache->total; i++) {
+    uint32_t slot = hashPath(cache->entries[i].fullPath) & mask;
+    while (cache->index[slot] != 0) {
+      // Skip duplicate paths on the same device, the first entry wins
+      CacheEntry *entry = &cache->entries[cache->index[slot] - 1];
+      if ((entry->device == cache->entries[i].device) && !strcmp(entry->fullPath, cache->entries[i].fullPath))
+        goto next;
+      slot = (slot + 1) & mask;
+    }
+    cache->index[slot] = i + 1;
+  next:;
+  }
+}
+
 // Frees memory used by title ID cache
 // All pointers to cache entries (including title IDs) will be invalid
 void freeTitleCache(TitleIDCache *cache) {
   if (cache == NULL)
     return;
 
-  for (int i = 0; i < cache->total; i++) {
-    free(cache->entries[i].fullPath);
+  // Entries and hash index are stored in the same buffer as file contents
+  free(cache->data);
+  free(cache);
+}
+
+//
+// Target list snapshot
+//
+
+#define SNAPSHOT_MAGIC "NTGL"
+#define SNAPSHOT_VERSION 1
+// Number of device modes stored in the snapshot header
+#define SNAPSHOT_MAX_DEVICES 16
+
+const char snapshotFile[] = "/targets.bin";
+#define MAX_SNAPSHOT_PATH_LEN MASS_PLACEHOLDER_LEN + BASE_CONFIG_PATH_LEN + (sizeof(snapshotFile) / sizeof(char))
+
+// Snapshot file header.
+// All fields are fixed-width and little-endian.
+// Header is followed by the entry table in list order and the string table
+// that contains null-terminated full paths, names and title IDs.
+typedef struct {
+  char magic[4];                             // Must be always equal to SNAPSHOT_MAGIC
+  uint8_t version;                           // Snapshot version
+  uint8_t reserved[3];                       //
+  uint32_t total;                            // Total number of targets
+  uint32_t checksum;                         // CRC32 of the entry and string tables
+  uint8_t deviceModes[SNAPSHOT_MAX_DEVICES]; // Modes of mapped devices. Unmapped devices are set to MODE_ALL
+} SnapshotHeader;
+
+// Snapshot file entry
+typedef struct {
+  uint32_t pathOffset; // Offset of full path in the string table
+  uint32_t nameOffset; // Offset of target name in the string table
+  uint32_t idOffset;   // Offset of title ID in the string table
+  uint8_t deviceType;  // Device type
+  uint8_t reserved[3]; //
+  uint64_t size;       // ISO size
+} SnapshotRecord;
+
+// Header of the snapshot stored on the device, used to skip writing unchanged snapshots
+static SnapshotHeader storedSnapshot;
+
+// Fills deviceModes with modes of currently mapped devices
+static void getSnapshotDeviceModes(uint8_t *deviceModes) {
+  memset(deviceModes, MODE_ALL, SNAPSHOT_MAX_DEVICES);
+  for (int i = 0; (i < MAX_MASS_DEVICES) && (i < SNAPSHOT_MAX_DEVICES); i++) {
+    if (deviceModeMap[i].mode == MODE_ALL)
+      break;
+    deviceModes[i] = deviceModeMap[i].mode;
   }
+}
 
-  free(cache->entries);
-  free(cache);
+// Saves the complete target list into the target list snapshot on the first storage device.
+// All targets must have a title ID. The file is not rewritten if its contents haven't changed
+int storeTargetListSnapshot(TargetList *list) {
+  if ((list->total == 0) || (deviceModeMap[0].mode == MODE_ALL))
+    return 0;
+
+  // Get the size of the string table
+  size_t stringTableSize = 0;
+  for (Target *target = list->first; target != NULL; target = target->next) {
+    if (target->id == NULL)
+      return -EINVAL;
+    stringTableSize += strlen(target->fullPath) + strlen(target->name) + strlen(target->id) + 3;
+  }
+
+  int size = sizeof(SnapshotHeader) + sizeof(SnapshotRecord) * list->total + stringTableSize;
+  char *buf = malloc(size);
+  if (buf == NULL) {
+    printf("ERROR: Can't allocate enough memory\n");
+    return -ENOMEM;
+  }
+
+  // Serialize targets in list order
+  SnapshotHeader *header = (SnapshotHeader *)buf;
+  SnapshotRecord *record = (SnapshotRecord *)&buf[sizeof(SnapshotHeader)];
+  char *stringTable = (char *)&record[list->total];
+  uint32_t offset = 0;
+  for (Target *target = list->first; target != NULL; target = target->next, record++) {
+    memset(record, 0, sizeof(SnapshotRecord));
+    record->deviceType = target->deviceType;
+    record->size = target->size;
+
+    record->pathOffset = offset;
+    offset += strlen(strcpy(&stringTable[offset], target->fullPath)) + 1;
+    record->nameOffset = offset;
+    offset += strlen(strcpy(&stringTable[offset], target->name)) + 1;
+    record->idOffset = offset;
+    offset += strlen(strcpy(&stringTable[offset], target->id)) + 1;
+  }
+
+  memset(header, 0, sizeof(SnapshotHeader));
+  memcpy(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic));
+  header->version = SNAPSHOT_VERSION;
+  header->total = list->total;
+  header->checksum = crc32(0, (unsigned char *)&buf[sizeof(SnapshotHeader)], size - sizeof(SnapshotHeader));
+  getSnapshotDeviceModes(header->deviceModes);
+  if (!memcmp(header, &storedSnapshot, sizeof(SnapshotHeader))) {
+    free(buf);
+    return 0;
+  }
+
+  // Make sure config directory exists
+  char snapshotPath[MAX_SNAPSHOT_PATH_LEN];
+  buildConfigFilePath(snapshotPath, MASS_PLACEHOLDER, NULL);
+  snapshotPath[4] = '0';
+  struct stat st;
+  if (stat(snapshotPath, &st) == -1) {
+    printf("Creating config directory: %s\n", snapshotPath);
+    if (mkdir(snapshotPath, 0777)) {
+      printf("ERROR: Failed to create directory\n");
+      free(buf);
+      return -EIO;
+    }
+  }
+  strcat(snapshotPath, snapshotFile);
+
+  printf("Updating target list snapshot with %d titles\n", list->total);
+  int fd = open(snapshotPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0) {
+    printf("ERROR: Failed to open target list snapshot for writing\n");
+    free(buf);
+    return -EIO;
+  }
+  if (write(fd, buf, size) != size) {
+    printf("ERROR: Failed to write target list snapshot: %d\n", errno);
+    close(fd);
+    remove(snapshotPath);
+    free(buf);
+    return -EIO;
+  }
+  close(fd);
+
+  memcpy(&storedSnapshot, header, sizeof(SnapshotHeader));
+  free(buf);
+  return 0;
+}
+
+// Loads target list snapshot into an empty list, allocating targets and strings from the list arena.
+// The file is read with a single read and targets point directly into the file contents.
+// Fails if the set of storage devices has changed since the snapshot was saved
+int loadTargetListSnapshot(TargetList *list) {
+  memset(&storedSnapshot, 0, sizeof(SnapshotHeader));
+  if (deviceModeMap[0].mode == MODE_ALL)
+    return -ENODEV;
+
+  char snapshotPath[MAX_SNAPSHOT_PATH_LEN];
+  buildConfigFilePath(snapshotPath, MASS_PLACEHOLDER, snapshotFile);
+  snapshotPath[4] = '0';
+
+  int fd = open(snapshotPath, O_RDONLY);
+  if (fd < 0)
+    return -ENOENT;
+
+  int fileSize = lseek(fd, 0, SEEK_END);
+  lseek(fd, 0, SEEK_SET);
+  char *buf = NULL;
+  if ((fileSize < (int)sizeof(SnapshotHeader)) || ((buf = arenaAlloc(&list->arena, fileSize)) == NULL) ||
+      (read(fd, buf, fileSize) != fileSize)) {
+    printf("ERROR: Failed to read target list snapshot\n");
+    close(fd);
+    return -EIO;
+  }
+  close(fd);
+
+  // Make sure the snapshot is valid and was saved with the same devices
+  SnapshotHeader *header = (SnapshotHeader *)buf;
+  uint8_t deviceModes[SNAPSHOT_MAX_DEVICES];
+  getSnapshotDeviceModes(deviceModes);
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) || (header->version != SNAPSHOT_VERSION)) {
+    printf("ERROR: Unsupported target list snapshot, ignoring\n");
+    return -EINVAL;
+  }
+  if (memcmp(header->deviceModes, deviceModes, SNAPSHOT_MAX_DEVICES)) {
+    printf("Devices have changed since the target list snapshot was saved, ignoring\n");
+    return -ENODEV;
+  }
+  // Every entry takes at least three null-terminators
+  if ((header->total == 0) || (header->total > UINT16_MAX) ||
+      (header->total > (fileSize - sizeof(SnapshotHeader)) / (sizeof(SnapshotRecord) + 3)) ||
+      (crc32(0, (unsigned char *)&buf[sizeof(SnapshotHeader)], fileSize - sizeof(SnapshotHeader)) != header->checksum)) {
+    printf("ERROR: Target list snapshot is corrupted, ignoring\n");
+    return -EINVAL;
+  }
+  SnapshotRecord *records = (SnapshotRecord *)&buf[sizeof(SnapshotHeader)];
+  char *stringTable = (char *)&records[header->total];
+  uint32_t stringTableSize = &buf[fileSize] - stringTable;
+  if (stringTable[stringTableSize - 1] != '\0') {
+    printf("ERROR: Target list snapshot is corrupted, ignoring\n");
+    return -EINVAL;
+  }
+
+  // Initialize targets
+  Target *targets = arenaAlloc(&list->arena, sizeof(Target) * header->total);
+  list->targets = arenaAlloc(&list->arena, sizeof(Target *) * header->total);
+  if ((targets == NULL) || (list->targets == NULL)) {
+    printf("ERROR: Can't allocate enough memory\n");
+    return -ENOMEM;
+  }
+  for (int i = 0; i < header->total; i++) {
+    SnapshotRecord *record = &records[i];
+    if ((record->pathOffset >= stringTableSize) || (record->nameOffset >= stringTableSize) || (record->idOffset >= stringTableSize)) {
+      printf("ERROR: Target list snapshot is corrupted, ignoring\n");
+      list->targets = NULL;
+      return -EINVAL;
+    }
+
+    Target *target = &targets[i];
+    target->idx = i;
+    target->fullPath = &stringTable[record->pathOffset];
+    target->name = &stringTable[record->nameOffset];
+    target->id = &stringTable[record->idOffset];
+    target->size = record->size;
+    target->deviceType = record->deviceType;
+    target->prev = (i > 0) ? &targets[i - 1] : NULL;
+    target->next = (i < header->total - 1) ? &targets[i + 1] : NULL;
+    list->targets[i] = target;
+  }
+  list->first = &targets[0];
+  list->last = &targets[header->total - 1];
+  list->total = header->total;
+
+  memcpy(&storedSnapshot, header, sizeof(SnapshotHeader));
+  return 0;
+}
+
+//
+// Directory cache
+//
+
+#define DIR_CACHE_MAGIC "NDIR"
+#define DIR_CACHE_VERSION 5
+
+const char dirCacheFile[] = "/dirs.bin";
+#define MAX_DIR_CACHE_PATH_LEN MASS_PLACEHOLDER_LEN + BASE_CONFIG_PATH_LEN + (sizeof(dirCacheFile) / sizeof(char))
+
+// Directory cache file header
+typedef struct {
+  char magic[4];         // Must be always equal to DIR_CACHE_MAGIC
+  uint8_t version;       // Cache version
+  uint8_t reserved[3];   //
+  uint32_t total;        // Total number of records
+  uint32_t size;         // Total size of all records
+  uint32_t fullReadTime; // Time of the last scan that read all directories
+  uint32_t checksum;     // CRC32 of all records
+} DirCacheHeader;
+
+static int isDirectoryRecordValid(DirCacheRecord *record);
+
+// Loads directory cache from the device at mountpoint
+int loadDirectoryCache(DirectoryCache *cache, const char *mountpoint) {
+  memset(cache, 0, sizeof(DirectoryCache));
+
+  char cachePath[MAX_DIR_CACHE_PATH_LEN];
+  buildConfigFilePath(cachePath, mountpoint, dirCacheFile);
+
+  FILE *file = fopen(cachePath, "rb");
+  if (file == NULL)
+    return -ENOENT;
+
+  // Read and validate the header
+  DirCacheHeader header;
+  if (fread(&header, sizeof(DirCacheHeader), 1, file) != 1) {
+    printf("ERROR: Failed to read directory cache header\n");
+    fclose(file);
+    return -EIO;
+  }
+  if (memcmp(header.magic, DIR_CACHE_MAGIC, sizeof(header.magic)) || (header.version != DIR_CACHE_VERSION)) {
+    printf("ERROR: Unsupported directory cache, ignoring\n");
+    fclose(file);
+    return -EINVAL;
+  }
+  // Every record takes at least the size of the record header
+  if (header.total > header.size / sizeof(DirCacheRecord)) {
+    printf("ERROR: Directory cache is corrupted, ignoring\n");
+    fclose(file);
+    return -EINVAL;
+  }
+
+  // Read all records with a single read
+  cache->indexSize = getCacheIndexSize(header.total);
+  cache->data = malloc(header.size);
+  cache->offsets = malloc(sizeof(uint32_t) * header.total);
+  cache->index = calloc(cache->indexSize, sizeof(int));
+  if ((cache->data == NULL) || (cache->offsets == NULL) || (cache->index == NULL)) {
+    printf("ERROR: Can't allocate enough memory\n");
+    fclose(file);
+    freeDirectoryCache(cache);
+    return -ENOMEM;
+  }
+  if (fread(cache->data, header.size, 1, file) != 1) {
+    printf("ERROR: Failed to read directory cache\n");
+    fclose(file);
+    freeDirectoryCache(cache);
+    return -EIO;
+  }
+  fclose(file);
+  if (crc32(0, (unsigned char *)cache->data, header.size) != header.checksum) {
+    printf("ERROR: Directory cache checksum doesn't match, ignoring\n");
+    freeDirectoryCache(cache);
+    return -EINVAL;
+  }
+  cache->size = header.size;
+  cache->capacity = header.size;
+  cache->fullReadTime = header.fullReadTime;
+
+  // Index records by path hash and make sure they are valid
+  uint32_t offset = 0;
+  uint32_t mask = cache->indexSize - 1;
+  DirCacheRecord *record;
+  for (uint32_t i = 0; i < header.total; i++) {
+    record = (DirCacheRecord *)&cache->data[offset];
+    if ((offset + sizeof(DirCacheRecord) > header.size) || (offset + record->size > header.size) || !isDirectoryRecordValid(record)) {
+      printf("ERROR: Directory cache is corrupted, ignoring\n");
+      freeDirectoryCache(cache);
+      return -EINVAL;
+    }
+    cache->offsets[i] = offset;
+    offset += record->size;
+
+    uint32_t slot = record->pathHash & mask;
+    while (cache->index[slot] != 0)
+      slot = (slot + 1) & mask;
+    cache->index[slot] = i + 1;
+  }
+  if (offset != header.size) {
+    printf("ERROR: Directory cache is corrupted, ignoring\n");
+    freeDirectoryCache(cache);
+    return -EINVAL;
+  }
+  cache->total = header.total;
+  return 0;
+}
+
+// Returns 1 if the record path and all record entries fit within the record
+static int isDirectoryRecordValid(DirCacheRecord *record) {
+  if (!record->pathLength || (record->size < sizeof(DirCacheRecord) + record->pathLength) || (record->size & 3))
+    return 0;
+
+  char *path = (char *)(record + 1);
+  if (path[record->pathLength - 1] != '\0')
+    return 0;
+
+  char *entry = path + record->pathLength;
+  char *end = (char *)record + record->size;
+  char *nameEnd;
+  for (int i = 0; i < record->nameCount; i++) {
+    // Entry must have a valid type and a null-terminated name followed by the file size or directory modification time
+    if ((entry >= end) || ((entry[0] != DIR_CACHE_FILE) && (entry[0] != DIR_CACHE_DIR)) ||
+        ((nameEnd = memchr(&entry[1], '\0', end - &entry[1])) == NULL))
+      return 0;
+
+    entry = nameEnd + 1 + ((entry[0] == DIR_CACHE_FILE) ? sizeof(uint64_t) : sizeof(uint32_t));
+    if (entry > end)
+      return 0;
+  }
+  return 1;
+}
+
+// Saves directory cache to the device at mountpoint
+int storeDirectoryCache(DirectoryCache *cache, const char *mountpoint) {
+  char cachePath[MAX_DIR_CACHE_PATH_LEN];
+  buildConfigFilePath(cachePath, mountpoint, NULL);
+
+  // Make sure config directory exists
+  struct stat st;
+  if (stat(cachePath, &st) == -1) {
+    printf("Creating config directory: %s\n", cachePath);
+    if (mkdir(cachePath, 0777)) {
+      printf("ERROR: Failed to create directory\n");
+      return -EIO;
+    }
+  }
+  strcat(cachePath, dirCacheFile);
+
+  FILE *file = fopen(cachePath, "wb");
+  if (file == NULL) {
+    printf("ERROR: Failed to open directory cache file for writing\n");
+    return -EIO;
+  }
+
+  DirCacheHeader header = {.magic = DIR_CACHE_MAGIC,
+                           .version = DIR_CACHE_VERSION,
+                           .total = cache->total,
+                           .size = cache->size,
+                           .fullReadTime = cache->fullReadTime,
+                           .checksum = crc32(0, (unsigned char *)cache->data, cache->size)};
+  if ((fwrite(&header, sizeof(DirCacheHeader), 1, file) != 1) || (cache->size && (fwrite(cache->data, cache->size, 1, file) != 1))) {
+    printf("ERROR: Failed to write directory cache: %d\n", errno);
+    fclose(file);
+    remove(cachePath);
+    return -EIO;
+  }
+  fclose(file);
+  return 0;
+}
+
+// Returns a pointer to cached directory record or NULL if path is not cached
+// or modification time is not available or doesn't match
+DirCacheRecord *getCachedDirectory(DirectoryCache *cache, const char *path, uint32_t mtime) {
+  if (!mtime || !cache->total)
+    return NULL;
+
+  uint32_t hash = hashPath(path);
+  uint32_t mask = cache->indexSize - 1;
+  DirCacheRecord *record;
+  for (uint32_t slot = hash & mask; cache->index[slot] != 0; slot = (slot + 1) & mask) {
+    record = (DirCacheRecord *)&cache->data[cache->offsets[cache->index[slot] - 1]];
+    if ((record->pathHash == hash) && !strcmp((char *)(record + 1), path))
+      return (record->mtime == mtime) ? record : NULL;
+  }
+  return NULL;
+}
+
+// Makes sure cache has enough space to store extra bytes
+static int reserveDirectoryCache(DirectoryCache *cache, int extra) {
+  if (cache->size + extra <= cache->capacity)
+    return 0;
+
+  int capacity = (cache->capacity) ? cache->capacity : 4096;
+  while (capacity < cache->size + extra)
+    capacity *= 2;
+
+  char *data = realloc(cache->data, capacity);
+  if (data == NULL)
+    return -ENOMEM;
+
+  cache->data = data;
+  cache->capacity = capacity;
+  return 0;
+}
+
+// Starts a new record for the directory at path and returns its offset or a negative error
+int beginDirectoryRecord(DirectoryCache *cache, const char *path, uint32_t mtime) {
+  int pathLength = strlen(path) + 1;
+  // Reserve 3 extra bytes for padding
+  if (reserveDirectoryCache(cache, sizeof(DirCacheRecord) + pathLength + 3))
+    return -ENOMEM;
+
+  int offset = cache->size;
+  DirCacheRecord *record = (DirCacheRecord *)&cache->data[offset];
+  memset(record, 0, sizeof(DirCacheRecord));
+  record->mtime = mtime;
+  record->pathHash = hashPath(path);
+  record->pathLength = pathLength;
+  memcpy(record + 1, path, pathLength);
+
+  cache->size += sizeof(DirCacheRecord) + pathLength;
+  cache->total++;
+  return offset;
+}
+
+// Appends an entry to the record at offset. size is ignored for directories and mtime is ignored for files
+int appendDirectoryRecordEntry(DirectoryCache *cache, int offset, char type, const char *name, uint64_t size, uint32_t mtime) {
+  int nameLength = strlen(name) + 1;
+  // Reserve space for the file size and 3 extra bytes for padding
+  if (reserveDirectoryCache(cache, nameLength + 1 + sizeof(uint64_t) + 3))
+    return -ENOMEM;
+
+  cache->data[cache->size] = type;
+  memcpy(&cache->data[cache->size + 1], name, nameLength);
+  cache->size += nameLength + 1;
+  if (type == DIR_CACHE_FILE) {
+    memcpy(&cache->data[cache->size], &size, sizeof(uint64_t));
+    cache->size += sizeof(uint64_t);
+  } else {
+    memcpy(&cache->data[cache->size], &mtime, sizeof(uint32_t));
+    cache->size += sizeof(uint32_t);
+  }
+
+  ((DirCacheRecord *)&cache->data[offset])->nameCount++;
+  return 0;
+}
+
+// Returns a pointer to the record entry following entry
+char *getNextDirectoryRecordEntry(char *entry) {
+  int length = strlen(&entry[1]) + 2;
+  if (entry[0] == DIR_CACHE_FILE)
+    length += sizeof(uint64_t);
+  else
+    length += sizeof(uint32_t);
+  return entry + length;
+}
+
+// Returns file size stored in the file record entry
+uint64_t getDirectoryRecordEntrySize(char *entry) {
+  uint64_t size;
+  memcpy(&size, &entry[strlen(&entry[1]) + 2], sizeof(uint64_t));
+  return size;
+}
+
+// Returns directory modification time stored in the directory record entry
+uint32_t getDirectoryRecordEntryMtime(char *entry) {
+  uint32_t mtime;
+  memcpy(&mtime, &entry[strlen(&entry[1]) + 2], sizeof(uint32_t));
+  return mtime;
+}
+
+// Finalizes the record at offset
+void endDirectoryRecord(DirectoryCache *cache, int offset) {
+  // Pad the record to 4 bytes
+  while (cache->size & 3)
+    cache->data[cache->size++] = '\0';
+
+  DirCacheRecord *record = (DirCacheRecord *)&cache->data[offset];
+  record->size = cache->size - offset;
+}
+
+// Copies the record into cache and returns its offset or a negative error
+int copyDirectoryRecord(DirectoryCache *cache, DirCacheRecord *record) {
+  if (reserveDirectoryCache(cache, record->size))
+    return -ENOMEM;
+
+  int offset = cache->size;
+  memcpy(&cache->data[offset], record, record->size);
+  cache->size += record->size;
+  cache->total++;
+  return offset;
+}
+
+// Returns a pointer to the record at offset
+DirCacheRecord *getDirectoryRecord(DirectoryCache *cache, int offset) { return (DirCacheRecord *)&cache->data[offset]; }
+
+// Returns 1 if both caches contain the same records and full read time
+int isDirectoryCacheEqual(DirectoryCache *cache1, DirectoryCache *cache2) {
+  if ((cache1->fullReadTime != cache2->fullReadTime) || (cache1->total != cache2->total) || (cache1->size != cache2->size))
+    return 0;
+  return !cache1->size || !memcmp(cache1->data, cache2->data, cache1->size);
+}
+
+// Frees memory used by directory cache contents
+void freeDirectoryCache(DirectoryCache *cache) {
+  free(cache->data);
+  free(cache->offsets);
+  free(cache->index);
+  memset(cache, 0, sizeof(DirectoryCache));
 }
@@ -1,11 +1,11 @@
 #include "common.h"
 #include <errno.h>
-#include <fcntl.h>
-#include <limits.h>
+#include <fileXio_rpc.h>
+#include <io_common.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 
 //
 // This code is based on isofs.irx and title ID parsing code from Neutrino
@@ -15,8 +15,18 @@
 #define TOC_LBA 16
 #define SYSTEM_CNF_NAME "SYSTEM.CNF;1"
 
+// Number of sectors read starting from TOC_LBA.
+// On most ISOs this also covers the root directory and SYSTEM.CNF,
+// so the title ID can be extracted with a single read
+#define PREFETCH_SECTORS 8
+// Maximum root directory size
+#define MAX_ROOT_DIR_SIZE (64 * SECTOR_SIZE)
+// Maximum SYSTEM.CNF size
+#define MAX_SYSTEM_CNF_SIZE SECTOR_SIZE
+
 struct dirTOCEntry {
-  short length;
+  uint8_t length;           // 0
+  uint8_t extAttrLength;    // 1
   uint32_t fileLBA;         // 2
   uint32_t fileLBA_bigend;  // 6
   uint32_t fileSize;        // 10
@@ -29,149 +39,170 @@ struct dirTOCEntry {
   char filename[128];       // 33
 } __attribute__((packed));
 
-static unsigned char iso_buf[SECTOR_SIZE];
+// Size of the directory record without the file name
+#define DIR_RECORD_HEADER_SIZE 33
+
+// Buffer for sectors read starting from TOC_LBA
+static unsigned char iso_buf[PREFETCH_SECTORS * SECTOR_SIZE];
 
-// Sets file offset to specified LBA while handling large LBAs
-static void longLseek(int fd, unsigned int lba);
-// Reads Primary Volume Descriptor from specified LBA and extracts root directory LBA
-static int getPVD(int fd, uint32_t *lba, int *length);
-// Retrieves SYSTEM.CNF TOC entry using specified root directory TOC
-static struct dirTOCEntry *getTOCEntry(int fd, uint32_t tocLBA, int tocLength);
+// Reads size bytes starting from the specified LBA into buf.
+// Returns the number of bytes read or a negative error code
+static int readLBA(int fd, uint32_t lba, void *buf, int size);
+// Returns a pointer to size bytes located at the specified LBA.
+// Data is taken from iso_buf if it has already been read, otherwise it's read into a new buffer returned in allocated.
+static unsigned char *getLBAData(int fd, uint32_t lba, int size, int prefetched, unsigned char **allocated);
+// Extracts root directory location from Primary Volume Descriptor
+static int getPVD(int prefetched, uint32_t *lba, int *size);
+// Retrieves SYSTEM.CNF TOC entry from the root directory
+static struct dirTOCEntry *getTOCEntry(unsigned char *rootDir, int size);
 
 // Loads SYSTEM.CNF from ISO and extracts title ID
 char *getTitleID(char *path) {
   // Open ISO
-  int fd = open(path, O_RDONLY);
+  int fd = fileXioOpen(path, FIO_O_RDONLY);
   if (fd < 0) {
-    logString("%s:\nERROR: Failed to open file: %d\n", path, fd);
+    printf("%s:\nERROR: Failed to open file: %d\n", path, fd);
     return NULL;
   }
 
+  char *titleID = NULL;
+  unsigned char *rootDirBuf = NULL;
+  unsigned char *systemCNFBuf = NULL;
+  char *systemCNF = NULL;
+
+  // Read PVD along with the following sectors
+  int prefetched = readLBA(fd, TOC_LBA, iso_buf, sizeof(iso_buf));
+
   // Get location of root directory entry
   uint32_t rootLBA = 0;
-  int rootLength = 0;
-  if (getPVD(fd, &rootLBA, &rootLength) != 0) {
-    logString("%s:\nERROR: Failed to parse ISO PVD\n", path);
-    close(fd);
-    return NULL;
+  int rootSize = 0;
+  if (getPVD(prefetched, &rootLBA, &rootSize) != 0) {
+    printf("%s:\nERROR: Failed to parse ISO PVD\n", path);
+    goto out;
   }
 
-  // Get SYSTEM.CNF entry
-  struct dirTOCEntry *tocEntry = getTOCEntry(fd, rootLBA, rootLength);
+  // Read the whole root directory extent and get SYSTEM.CNF entry
+  unsigned char *rootDir = getLBAData(fd, rootLBA, rootSize, prefetched, &rootDirBuf);
+  struct dirTOCEntry *tocEntry = NULL;
+  if (rootDir != NULL)
+    tocEntry = getTOCEntry(rootDir, rootSize);
   if (tocEntry == NULL) {
-    logString("%s:\nERROR: Failed to find SYSTEM.CNF\n", path);
-    close(fd);
-    return NULL;
+    printf("%s:\nERROR: Failed to find SYSTEM.CNF\n", path);
+    goto out;
   }
 
-  // Seek to SYSTEM.CNF location and read file contents
-  longLseek(fd, tocEntry->fileLBA);
-  char *systemCNF = malloc(tocEntry->length);
-  if (read(fd, systemCNF, tocEntry->length) != tocEntry->length) {
-    logString("%s:\nERROR: Failed to read SYSTEM.CNF\n", path);
-    free(systemCNF);
-    close(fd);
-    return NULL;
+  // Read SYSTEM.CNF contents using the file size from the directory record
+  int systemCNFSize = tocEntry->fileSize;
+  if (systemCNFSize > MAX_SYSTEM_CNF_SIZE)
+    systemCNFSize = MAX_SYSTEM_CNF_SIZE;
+
+  unsigned char *systemCNFData = getLBAData(fd, tocEntry->fileLBA, systemCNFSize, prefetched, &systemCNFBuf);
+  if ((systemCNFSize == 0) || (systemCNFData == NULL) || ((systemCNF = malloc(systemCNFSize + 1)) == NULL)) {
+    printf("%s:\nERROR: Failed to read SYSTEM.CNF\n", path);
+    goto out;
   }
+  memcpy(systemCNF, systemCNFData, systemCNFSize);
+  systemCNF[systemCNFSize] = '\0';
 
   char *boot2Arg = strstr(systemCNF, "BOOT2");
   if (boot2Arg == NULL) {
-    logString("%s:\nERROR: BOOT2 not found in SYSTEM.CNF\n", path);
-    free(systemCNF);
-    close(fd);
-    return NULL;
+    printf("%s:\nERROR: BOOT2 not found in SYSTEM.CNF\n", path);
+    goto out;
   }
 
-  char *titleID = calloc(sizeof(char), 12);
   // Locate and set ELF file name
   char *selfFile = strstr(boot2Arg, "cdrom0:");
   char *argEnd = strstr(boot2Arg, ";");
   if (selfFile == NULL || argEnd == NULL) {
-    logString("%s:\nERROR: File name not found in SYSTEM.CNF\n", path);
-    free(titleID);
-    titleID = NULL;
-  } else {
-    // Extract title ID
-    argEnd[1] = '1';
-    argEnd[2] = '\0';
-    memcpy(titleID, &selfFile[8], 11);
+    printf("%s:\nERROR: File name not found in SYSTEM.CNF\n", path);
+    goto out;
   }
 
+  // Extract title ID
+  titleID = calloc(sizeof(char), 12);
+  argEnd[1] = '1';
+  argEnd[2] = '\0';
+  memcpy(titleID, &selfFile[8], 11);
+
+out:
   free(systemCNF);
-  close(fd);
+  free(systemCNFBuf);
+  free(rootDirBuf);
+  fileXioClose(fd);
   return titleID;
 }
 
-// Sets file offset to specified LBA while handling large LBAs
-static void longLseek(int fd, unsigned int lba) {
-  // If offset fits into INT_MAX, seek and return
-  if (lba <= INT_MAX / SECTOR_SIZE) {
-    lseek(fd, lba * SECTOR_SIZE, SEEK_SET);
-    return;
-  }
+// Reads size bytes starting from the specified LBA into buf.
+// Returns the number of bytes read or a negative error code
+static int readLBA(int fd, uint32_t lba, void *buf, int size) {
+  int64_t res = fileXioLseek64(fd, (int64_t)lba * SECTOR_SIZE, SEEK_SET);
+  if (res < 0)
+    return res;
 
-  // Else, seek while handling overflows
-  unsigned int remaining, toSeek;
-  lseek(fd, INT_MAX / SECTOR_SIZE * SECTOR_SIZE, SEEK_SET);
-  remaining = lba - INT_MAX / SECTOR_SIZE;
-  while (remaining > 0) {
-    toSeek = remaining > INT_MAX / SECTOR_SIZE ? INT_MAX / SECTOR_SIZE : remaining;
-    lseek(fd, toSeek * SECTOR_SIZE, SEEK_CUR);
-    remaining -= toSeek;
-  }
+  return fileXioRead(fd, buf, size);
 }
 
-// Reads Primary Volume Descriptor from specified LBA and extracts root directory LBA
-static int getPVD(int fd, uint32_t *lba, int *length) {
-  // Seek to PVD LBA
-  longLseek(fd, TOC_LBA);
-  // Read the sector
-  if (read(fd, iso_buf, SECTOR_SIZE) == SECTOR_SIZE) {
-    // Make sure the sector contains PVD (type code 1, identifier CD001)
-    if ((iso_buf[0x00] == 1) && (!memcmp(&iso_buf[0x01], "CD001", 5))) {
-      // Read root directory entry and get LBA and length
-      struct dirTOCEntry *tocEntryPointer = (struct dirTOCEntry *)&iso_buf[0x9c];
-      *lba = tocEntryPointer->fileLBA;
-      *length = tocEntryPointer->length;
-      return 0;
-    } else {
-      return -EINVAL;
-    }
+// Returns a pointer to size bytes located at the specified LBA.
+// Data is taken from iso_buf if it has already been read, otherwise it's read into a new buffer returned in allocated.
+static unsigned char *getLBAData(int fd, uint32_t lba, int size, int prefetched, unsigned char **allocated) {
+  // Check if the data has already been read
+  if ((lba >= TOC_LBA) && (lba < TOC_LBA + PREFETCH_SECTORS) && ((int)(lba - TOC_LBA) * SECTOR_SIZE + size <= prefetched))
+    return &iso_buf[(lba - TOC_LBA) * SECTOR_SIZE];
+
+  unsigned char *buf = malloc(size);
+  if (buf == NULL)
+    return NULL;
+
+  if (readLBA(fd, lba, buf, size) != size) {
+    free(buf);
+    return NULL;
   }
-  return -EIO;
+  *allocated = buf;
+  return buf;
+}
+
+// Extracts root directory location from Primary Volume Descriptor
+static int getPVD(int prefetched, uint32_t *lba, int *size) {
+  if (prefetched < SECTOR_SIZE)
+    return -EIO;
+
+  // Make sure the sector contains PVD (type code 1, identifier CD001)
+  if ((iso_buf[0x00] != 1) || memcmp(&iso_buf[0x01], "CD001", 5))
+    return -EINVAL;
+
+  // Read root directory entry and get LBA and extent size
+  struct dirTOCEntry *tocEntryPointer = (struct dirTOCEntry *)&iso_buf[0x9c];
+  if ((tocEntryPointer->fileSize == 0) || (tocEntryPointer->fileSize > MAX_ROOT_DIR_SIZE))
+    return -EINVAL;
+
+  *lba = tocEntryPointer->fileLBA;
+  *size = tocEntryPointer->fileSize;
+  return 0;
 }
 
-// Retrieves SYSTEM.CNF TOC entry using specified root directory TOC
-static struct dirTOCEntry *getTOCEntry(int fd, uint32_t tocLBA, int tocLength) {
-  // Read TOC entries
-  while (tocLength > 0) {
-    // Seek to next LBA
-    longLseek(fd, tocLBA);
-    // Read the sector
-    if (read(fd, iso_buf, SECTOR_SIZE) != SECTOR_SIZE) {
-      return NULL;
+// Retrieves SYSTEM.CNF TOC entry from the root directory
+static struct dirTOCEntry *getTOCEntry(unsigned char *rootDir, int size) {
+  int tocPos = 0;
+  struct dirTOCEntry *tocEntryPointer;
+  while (tocPos + DIR_RECORD_HEADER_SIZE <= size) {
+    tocEntryPointer = (struct dirTOCEntry *)&rootDir[tocPos];
+
+    if (tocEntryPointer->length == 0) {
+      // Directory records never cross sector boundaries, continue from the next sector
+      tocPos = (tocPos / SECTOR_SIZE + 1) * SECTOR_SIZE;
+      continue;
     }
 
-    // Read directory entries until the end of sector
-    int tocPos = 0;
-    struct dirTOCEntry *tocEntryPointer;
-    do {
-      tocEntryPointer = (struct dirTOCEntry *)&iso_buf[tocPos];
-
-      if (tocEntryPointer->length == 0)
-        break;
-
-      if (tocEntryPointer->filenameLength && !strcmp(SYSTEM_CNF_NAME, tocEntryPointer->filename)) {
-        // File has been found
-        return tocEntryPointer;
-      }
-      // Advance to the next entry
-      tocPos += (tocEntryPointer->length << 16) >> 16;
-    } while (tocPos < 2016);
-
-    // Get next sector LBA
-    tocLength -= SECTOR_SIZE;
-    tocLBA++;
+    if ((tocEntryPointer->length < DIR_RECORD_HEADER_SIZE) || (tocPos + tocEntryPointer->length > size))
+      break;
+
+    if ((tocEntryPointer->filenameLength == sizeof(SYSTEM_CNF_NAME) - 1) &&
+        !memcmp(SYSTEM_CNF_NAME, tocEntryPointer->filename, sizeof(SYSTEM_CNF_NAME) - 1)) {
+      // File has been found
+      return tocEntryPointer;
+    }
+    // Advance to the next entry
+    tocPos += tocEntryPointer->length;
   }
 
   return NULL;
@@ -29,6 +29,8 @@ static char neutrinoMassFallbackPath[] = "massX:/neutrino/neutrino.elf";
 #define OPTION_480P "480p"
 #define OPTION_MODE "mode"
 #define OPTION_UDPBD_IP "udpbd_ip"
+#define OPTION_SCAN_PATH "scan_path"
+#define OPTION_SCAN_EXCLUDE "scan_exclude"
 
 #ifndef GIT_VERSION
 #define GIT_VERSION "v-0.0.0-unknown"
@@ -133,6 +135,7 @@ void initOptions(char *basePath) {
   LAUNCHER_OPTIONS.is480pEnabled = 0;
   LAUNCHER_OPTIONS.mode = MODE_ALL;
   LAUNCHER_OPTIONS.udpbdIp[0] = '\0';
+  memset(&LAUNCHER_OPTIONS.scanFilter, 0, sizeof(ScanFilter));
 
   char lineBuffer[PATH_MAX + sizeof(optionsFile) + 1];
   strcpy(lineBuffer, basePath);
@@ -157,6 +160,12 @@ void initOptions(char *basePath) {
         LAUNCHER_OPTIONS.mode = parseMode(arg->value);
       } else if (strcmp(OPTION_UDPBD_IP, arg->arg) == 0) {
         strlcpy(LAUNCHER_OPTIONS.udpbdIp, arg->value, sizeof(LAUNCHER_OPTIONS.udpbdIp));
+      } else if (strcmp(OPTION_SCAN_PATH, arg->arg) == 0) {
+        if (addScanPath(&LAUNCHER_OPTIONS.scanFilter, arg->value))
+          logString("ERROR: Failed to add scan path %s\n", arg->value);
+      } else if (strcmp(OPTION_SCAN_EXCLUDE, arg->arg) == 0) {
+        if (addScanExcludePattern(&LAUNCHER_OPTIONS.scanFilter, arg->value))
+          logString("ERROR: Invalid exclusion pattern %s\n", arg->value);
       }
     }
     arg = arg->next;
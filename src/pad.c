@@ -1,68 +1,214 @@
+// Samples gamepads in a separate thread and turns button state changes into events
 #include "pad.h"
+#include "vsync.h"
+#include <errno.h>
 #include <kernel.h>
 #include <libpad.h>
+#include <malloc.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+// Number of queued events. Must be a power of two
+#define PAD_EVENT_QUEUE_SIZE 64
+// Pad thread stack size
+#define PAD_THREAD_STACK_SIZE 0x2000
+// Number of buttons reported by libpad
+#define PAD_BUTTON_COUNT 16
+
+// Single-producer, single-consumer event queue.
+// Events are written only by the pad thread and read only by the UI thread, so no locking is needed
+typedef struct {
+  PadEvent events[PAD_EVENT_QUEUE_SIZE];
+  volatile uint32_t head; // Incremented by the pad thread after writing an event
+  volatile uint32_t tail; // Incremented by the UI thread after reading an event
+} PadEventQueue;
+
+// Pad thread state
+typedef struct {
+  PadEventQueue queue;
+  uint32_t buttons;                          // Buttons held during the last sample
+  uint32_t nextRepeat[PAD_BUTTON_COUNT];     // Time of the next repeat of each held button
+  uint32_t repeatInterval[PAD_BUTTON_COUNT]; // Current repeat interval of each held button
+  volatile int isStopRequested;              // Set to stop the pad thread
+  int threadID;                              // Pad thread ID. Negative if the thread is not running
+  void *stack;                               // Pad thread stack
+  int vsyncSema;                             // Semaphore signalled on vsync
+  int eventSema;                             // Semaphore signalled when new events are queued
+  int doneSema;                              // Semaphore signalled when the pad thread finishes
+} PadState;
+
+extern void *_gp;
 
 static unsigned char padBuffer[2][256] ALIGNED(64);
-static unsigned int prevInputs[2] = {0, 0};
+static PadState pad = {.threadID = -1, .vsyncSema = -1, .eventSema = -1, .doneSema = -1};
 
-// Initializes gamepad input driver
-void initPad() {
+static void padThread(void *arg);
+
+// Initializes gamepad input driver and starts the thread that samples both gamepads on every vsync.
+// The thread runs with higher priority than the calling thread, so inputs are sampled even while the UI is busy
+int initPad() {
   padInit(0);
   padPortOpen(0, 0, padBuffer[0]);
   padPortOpen(1, 0, padBuffer[1]);
 
-  prevInputs[0] = 0;
-  prevInputs[1] = 0;
+  memset(&pad, 0, sizeof(PadState));
+  pad.threadID = -1;
+
+  ee_thread_status_t threadStatus;
+  int priority = 0;
+  if ((ReferThreadStatus(GetThreadId(), &threadStatus) >= 0) && (threadStatus.current_priority > 0))
+    priority = threadStatus.current_priority - 1;
+
+  ee_sema_t sema = {.init_count = 0, .max_count = 1, .option = 0};
+  pad.vsyncSema = createVSyncSema();
+  pad.eventSema = CreateSema(&sema);
+  pad.doneSema = CreateSema(&sema);
+  pad.stack = memalign(16, PAD_THREAD_STACK_SIZE);
+  if ((pad.vsyncSema < 0) || (pad.eventSema < 0) || (pad.doneSema < 0) || (pad.stack == NULL)) {
+    printf("ERROR: Failed to initialize pad thread\n");
+    closePad();
+    return -ENOMEM;
+  }
+
+  ee_thread_t thread = {
+      .func = padThread,
+      .stack = pad.stack,
+      .stack_size = PAD_THREAD_STACK_SIZE,
+      .gp_reg = &_gp,
+      .initial_priority = priority,
+      .attr = 0,
+      .option = 0,
+  };
+  int threadID = CreateThread(&thread);
+  if (threadID < 0) {
+    printf("ERROR: Failed to create pad thread: %d\n", threadID);
+    closePad();
+    return threadID;
+  }
+
+  pad.threadID = threadID;
+  StartThread(threadID, NULL);
+  return 0;
 }
 
-// Closes gamepad gamepad input driver
+// Stops the pad thread and closes gamepad input driver
 void closePad() {
+  if (pad.threadID >= 0) {
+    // The thread exits after the next vsync
+    pad.isStopRequested = 1;
+    WaitSema(pad.doneSema);
+    TerminateThread(pad.threadID);
+    DeleteThread(pad.threadID);
+    pad.threadID = -1;
+  }
+  if (pad.vsyncSema >= 0)
+    deleteVSyncSema(pad.vsyncSema);
+  if (pad.eventSema >= 0)
+    DeleteSema(pad.eventSema);
+  if (pad.doneSema >= 0)
+    DeleteSema(pad.doneSema);
+  pad.vsyncSema = pad.eventSema = pad.doneSema = -1;
+  free(pad.stack);
+  pad.stack = NULL;
+
   padPortClose(0, 0);
   padPortClose(1, 0);
   padEnd();
 }
 
-// Polls the gamepad and returns only changed inputs
-int readPad(int port, int slot) {
+// Returns current time in milliseconds
+static uint32_t getTime() { return (uint32_t)((uint64_t)clock() * 1000 / CLOCKS_PER_SEC); }
+
+// Returns currently pressed buttons
+static uint32_t readPad(int port, int slot) {
   struct padButtonStatus buttons;
-  uint32_t curInput, padData;
+  if (padRead(port, slot, &buttons) != 0)
+    return 0xffff ^ buttons.btns;
 
-  curInput = 0;
-  if (padRead(port, slot, &buttons) != 0) {
-    padData = 0xffff ^ buttons.btns;
+  return 0;
+}
 
-    curInput = padData & ~prevInputs[port];
-    prevInputs[port] = padData;
-  }
+// Queues the event. Events are dropped if the UI thread doesn't keep up
+static void pushPadEvent(PadEventType type, int button) {
+  PadEventQueue *queue = &pad.queue;
+  if (queue->head - queue->tail >= PAD_EVENT_QUEUE_SIZE)
+    return;
 
-  return curInput;
+  queue->events[queue->head & (PAD_EVENT_QUEUE_SIZE - 1)] = (PadEvent){.type = type, .button = button};
+  // Make sure the event is written before it's made visible to the UI thread
+  __sync_synchronize();
+  queue->head++;
 }
 
-// Polls the gamepad and returns currently pressed buttons
-int pollPad(int port, int slot) {
-  struct padButtonStatus buttons;
-  if (padRead(port, slot, &buttons) != 0) {
-    prevInputs[port] = 0xffff ^ buttons.btns;
-    return prevInputs[port];
+// Samples both gamepads and queues events for buttons that have been pressed, released or held long enough to repeat.
+// Returns the number of queued events
+static int samplePads() {
+  uint32_t buttons = readPad(0, 0) | readPad(1, 0);
+  uint32_t now = getTime();
+  int count = 0;
+
+  for (int i = 0; i < PAD_BUTTON_COUNT; i++) {
+    uint32_t button = 1 << i;
+    if (buttons & ~pad.buttons & button) {
+      pushPadEvent(PAD_EVENT_PRESS, button);
+      pad.nextRepeat[i] = now + PAD_REPEAT_DELAY;
+      pad.repeatInterval[i] = PAD_REPEAT_INTERVAL;
+      count++;
+    } else if (pad.buttons & ~buttons & button) {
+      pushPadEvent(PAD_EVENT_RELEASE, button);
+      count++;
+    } else if ((buttons & button) && ((int32_t)(now - pad.nextRepeat[i]) >= 0)) {
+      // Repeat held button, shortening the interval until it reaches the minimum
+      pushPadEvent(PAD_EVENT_REPEAT, button);
+      pad.nextRepeat[i] = now + pad.repeatInterval[i];
+      if (pad.repeatInterval[i] > PAD_REPEAT_MIN_INTERVAL + PAD_REPEAT_ACCELERATION)
+        pad.repeatInterval[i] -= PAD_REPEAT_ACCELERATION;
+      else
+        pad.repeatInterval[i] = PAD_REPEAT_MIN_INTERVAL;
+      count++;
+    }
   }
 
-  return 0;
+  pad.buttons = buttons;
+  return count;
 }
 
-// Blocks until input changes on any of the two gamepads.
-// To capture press of any button, pass -1.
-int waitForInput(int button) {
-  int curInputs;
-  while (1) {
-    curInputs = (readPad(0, 0) | readPad(1, 0));
-    if (curInputs & button)
-      return curInputs;
+// Samples gamepads on every vsync until stop is requested
+static void padThread(void *arg) {
+  while (!pad.isStopRequested) {
+    waitForVSync(pad.vsyncSema);
+    if (samplePads())
+      SignalSema(pad.eventSema);
   }
+  SignalSema(pad.doneSema);
+  ExitThread();
+}
+
+// Gets the next pad event without blocking.
+// Returns 1 if the event has been dequeued or 0 if there are no events
+int getPadEvent(PadEvent *event) {
+  PadEventQueue *queue = &pad.queue;
+  if (queue->tail == queue->head)
+    return 0;
+
+  *event = queue->events[queue->tail & (PAD_EVENT_QUEUE_SIZE - 1)];
+  // Make sure the event is read before the slot is released to the pad thread
+  __sync_synchronize();
+  queue->tail++;
+  return 1;
 }
 
+// Blocks until the next pad event is available
+void waitForPadEvent(PadEvent *event) {
+  while (!getPadEvent(event))
+    WaitSema(pad.eventSema);
+}
 
-// Returns inputs on both gamepads
-int pollInput() { return (pollPad(0, 0) | pollPad(1, 0)); }
\ No newline at end of file
+// Discards all queued pad events
+void clearPadEvents() {
+  PadEvent event;
+  while (getPadEvent(&event))
+    ;
+}
@@ -0,0 +1,120 @@
+// Implements scan path and exclusion pattern handling for the directory walker
+#include "scan_filter.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Normalizes path by making sure it starts with '/' and removing trailing '/'.
+// Device root is represented by an empty string.
+static char *normalizePath(const char *path) {
+  while (*path == '/')
+    path++;
+
+  int length = strlen(path);
+  while (length > 0 && path[length - 1] == '/')
+    length--;
+
+  char *result = calloc(sizeof(char), length + 2);
+  if (result == NULL)
+    return NULL;
+
+  if (length > 0) {
+    result[0] = '/';
+    strncpy(&result[1], path, length);
+  }
+  return result;
+}
+
+// Adds directory to the list of directories to scan.
+// Path is relative to device root.
+int addScanPath(ScanFilter *filter, const char *path) {
+  char **paths = realloc(filter->paths, sizeof(char *) * (filter->pathCount + 1));
+  if (paths == NULL)
+    return -ENOMEM;
+  filter->paths = paths;
+
+  if ((paths[filter->pathCount] = normalizePath(path)) == NULL)
+    return -ENOMEM;
+
+  filter->pathCount++;
+  return 0;
+}
+
+// Compiles glob pattern and adds it to the list of exclusion patterns.
+int addScanExcludePattern(ScanFilter *filter, const char *pattern) {
+  if (pattern[0] == '\0')
+    return -EINVAL;
+
+  ScanPattern *patterns = realloc(filter->patterns, sizeof(ScanPattern) * (filter->patternCount + 1));
+  if (patterns == NULL)
+    return -ENOMEM;
+  filter->patterns = patterns;
+
+  ScanPattern *compiled = &patterns[filter->patternCount];
+  compiled->matchFullPath = (strchr(pattern, '/') != NULL);
+  if (compiled->matchFullPath)
+    compiled->pattern = normalizePath(pattern);
+  else
+    compiled->pattern = strdup(pattern);
+
+  if (compiled->pattern == NULL)
+    return -ENOMEM;
+
+  // Convert pattern to uppercase once so matching only has to convert the path
+  for (char *c = compiled->pattern; *c != '\0'; c++)
+    *c = toupper((unsigned char)*c);
+
+  compiled->hasWildcards = (strpbrk(compiled->pattern, "*?") != NULL);
+  filter->patternCount++;
+  return 0;
+}
+
+// Matches str against uppercase glob pattern
+static int globMatch(const char *pattern, const char *str) {
+  const char *starPattern = NULL;
+  const char *starStr = NULL;
+
+  while (*str != '\0') {
+    if (*pattern == '*') {
+      // Remember star position and try to match the rest of the pattern
+      starPattern = ++pattern;
+      starStr = str;
+    } else if ((*pattern == '?' && *str != '/') || (*pattern == toupper((unsigned char)*str))) {
+      pattern++;
+      str++;
+    } else if ((starPattern != NULL) && (*starStr != '/')) {
+      // Let the last star consume one more character
+      pattern = starPattern;
+      str = ++starStr;
+    } else {
+      return 0;
+    }
+  }
+
+  while (*pattern == '*')
+    pattern++;
+  return *pattern == '\0';
+}
+
+// Compares str with uppercase literal pattern, ignoring case
+static int literalMatch(const char *pattern, const char *str) {
+  for (; *pattern != '\0'; pattern++, str++) {
+    if (*pattern != toupper((unsigned char)*str))
+      return 0;
+  }
+  return *str == '\0';
+}
+
+// Returns 1 if directory must not be scanned.
+// path is the full directory path relative to device root, name is the directory name.
+int isDirectoryExcluded(ScanFilter *filter, const char *path, const char *name) {
+  for (int i = 0; i < filter->patternCount; i++) {
+    ScanPattern *pattern = &filter->patterns[i];
+    const char *str = (pattern->matchFullPath) ? path : name;
+
+    if (pattern->hasWildcards ? globMatch(pattern->pattern, str) : literalMatch(pattern->pattern, str))
+      return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+// Wakes up threads on vertical blank without polling the GS
+#include "vsync.h"
+#include <errno.h>
+#include <kernel.h>
+#include <stdio.h>
+
+// Semaphores signalled by the interrupt handler. Unused entries are set to -1 by initVSync
+static volatile int vsyncSemas[MAX_VSYNC_SEMAS];
+static int vsyncHandlerID = -1;
+
+// Signals all vsync semaphores on vertical blank start
+static int vsyncHandler(int cause) {
+  for (int i = 0; i < MAX_VSYNC_SEMAS; i++) {
+    if (vsyncSemas[i] >= 0)
+      iSignalSema(vsyncSemas[i]);
+  }
+  ExitHandler();
+  return 0;
+}
+
+// Installs the vertical blank interrupt handler
+int initVSync() {
+  if (vsyncHandlerID >= 0)
+    return 0;
+
+  for (int i = 0; i < MAX_VSYNC_SEMAS; i++)
+    vsyncSemas[i] = -1;
+
+  if ((vsyncHandlerID = AddIntcHandler(INTC_VBLANK_S, vsyncHandler, 0)) < 0) {
+    printf("ERROR: Failed to add vsync handler: %d\n", vsyncHandlerID);
+    return -EIO;
+  }
+  EnableIntc(INTC_VBLANK_S);
+  return 0;
+}
+
+// Removes the vertical blank interrupt handler and deletes all vsync semaphores.
+// The interrupt is left enabled since other handlers might depend on it
+void closeVSync() {
+  if (vsyncHandlerID < 0)
+    return;
+
+  for (int i = 0; i < MAX_VSYNC_SEMAS; i++) {
+    if (vsyncSemas[i] >= 0)
+      deleteVSyncSema(vsyncSemas[i]);
+  }
+
+  RemoveIntcHandler(INTC_VBLANK_S, vsyncHandlerID);
+  vsyncHandlerID = -1;
+}
+
+// Creates a semaphore that is signalled on every vertical blank.
+// Returns semaphore ID or a negative error
+int createVSyncSema() {
+  if (vsyncHandlerID < 0)
+    return -ENODEV;
+
+  for (int i = 0; i < MAX_VSYNC_SEMAS; i++) {
+    if (vsyncSemas[i] >= 0)
+      continue;
+
+    // Signals are not accumulated, so a thread that misses several vertical blanks wakes up only once
+    ee_sema_t sema = {.init_count = 0, .max_count = 1, .option = 0};
+    int semaID = CreateSema(&sema);
+    if (semaID < 0)
+      return -ENOMEM;
+
+    vsyncSemas[i] = semaID;
+    return semaID;
+  }
+  return -ENOMEM;
+}
+
+// Deletes the semaphore created by createVSyncSema
+void deleteVSyncSema(int semaID) {
+  for (int i = 0; i < MAX_VSYNC_SEMAS; i++) {
+    if (vsyncSemas[i] == semaID) {
+      // Remove the semaphore from the handler before deleting it
+      vsyncSemas[i] = -1;
+      DeleteSema(semaID);
+      return;
+    }
+  }
+}
+
+// Puts the calling thread to sleep until the next vertical blank
+void waitForVSync(int semaID) {
+  // Discard the signal left from a vertical blank that has already passed
+  PollSema(semaID);
+  WaitSema(semaID);
+}